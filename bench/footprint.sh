@@ -0,0 +1,43 @@
+#!/bin/sh
+#
+# footprint.sh
+#
+# Report the flash and RAM taken by logger.c in every logger mode.
+#
+#     bench/footprint.sh                      # arm-none-eabi-gcc for a Cortex-M4, -Os
+#     CC=gcc SIZE=size CFLAGS=-O2 bench/footprint.sh
+#
+# text and data are stored in flash, data and bss take RAM.
+
+CC=${CC:-arm-none-eabi-gcc}
+SIZE=${SIZE:-arm-none-eabi-size}
+CFLAGS=${CFLAGS:--Os -mcpu=cortex-m4 -mthumb -ffunction-sections -fdata-sections}
+ROOT=$(dirname "$0")/..
+OBJECT=$(mktemp /tmp/logger_footprint.XXXXXX)
+
+trap 'rm -f "$OBJECT"' EXIT
+
+printf '%-56s %8s %8s %8s\n' "configuration" "text" "data" "bss"
+while read -r name flags; do
+    if ! $CC -std=c11 $CFLAGS $flags -I"$ROOT" -c "$ROOT/logger.c" -o "$OBJECT" 2>/dev/null; then
+        printf '%-56s %s\n' "$name" "build failed"
+        continue
+    fi
+    $SIZE "$OBJECT" | awk -v name="$name" 'NR == 2 { printf "%-56s %8s %8s %8s\n", name, $1, $2, $3 }'
+done <<CONFIGURATIONS
+disabled
+hard-fault -DHARD_FAULT_LOGGER_ENABLED
+enabled -DLOGGER_ENABLED
+enabled,tiny-printf -DLOGGER_ENABLED -DLOGGER_TINY_PRINTF
+ring -DLOGGER_RING
+deferred -DLOGGER_DEFERRED
+tokenized -DLOGGER_TOKENIZED
+tokenized,ring -DLOGGER_TOKENIZED -DLOGGER_RING
+async -DLOGGER_ASYNC
+thread-safe -DLOGGER_ENABLED -DLOGGER_THREAD_SAFE
+flash -DLOGGER_ENABLED -DLOGGER_FLASH
+batch -DLOGGER_BATCH
+batch,ring -DLOGGER_BATCH -DLOGGER_RING
+stats -DLOGGER_ENABLED -DLOGGER_STATS
+isr -DLOGGER_ENABLED -DLOGGER_ISR_ENABLED
+CONFIGURATIONS
@@ -0,0 +1,174 @@
+/*
+ * logger_bench.c
+ *
+ *  Microbenchmarks of LOG() and of the hard fault logger.
+ *
+ *  The same file runs on a host and on a Cortex-M. On a host it has its own main():
+ *
+ *      cc -O2 -I. -DLOGGER_ENABLED logger.c bench/logger_bench.c -o logger_bench && ./logger_bench
+ *      cc -O2 -I. -DHARD_FAULT_LOGGER_ENABLED logger.c bench/logger_bench.c -o logger_bench && ./logger_bench
+ *
+ *  On a Cortex-M3/M4/M7/M33 the cycles are read from DWT->CYCCNT. Build the file into the firmware with
+ *  -DLOGGER_BENCH_NO_MAIN and call LoggerBenchRun() once the clocks are set up; the results are printed with
+ *  printf, e.g. through semihosting or a retargeted UART. The log output itself goes to a sink that discards it,
+ *  so only the cost of the logger is measured. bench/footprint.sh reports the flash and RAM of every mode.
+ */
+
+#include "logger.h"
+
+#include <stdio.h>
+
+/**
+ * @brief Number of measured calls of every case.
+ */
+#ifndef LOGGER_BENCH_ITERATIONS
+#define LOGGER_BENCH_ITERATIONS                                                     1000
+#endif
+
+/**
+ * @brief Setup of the LOG() cases: the log ring is emptied so that the logs are queued, not dropped.
+ */
+#if defined(LOGGER_RING)
+#define LOGGER_BENCH_SETUP                                                          LoggerFlush()
+#else
+#define LOGGER_BENCH_SETUP                                                          (void) 0
+#endif
+
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) || defined(__ARM_ARCH_8M_MAIN__)
+
+#define LOGGER_BENCH_DEMCR                                                          (*(volatile uint32_t *) 0xE000EDFCu)
+#define LOGGER_BENCH_DWT_CTRL                                                       (*(volatile uint32_t *) 0xE0001000u)
+#define LOGGER_BENCH_DWT_CYCCNT                                                     (*(volatile uint32_t *) 0xE0001004u)
+#define LOGGER_BENCH_UNIT                                                           "cycles"
+
+/**
+ * @brief   Enable the DWT cycle counter.
+ */
+static void LoggerBenchInitCounter(void) {
+    LOGGER_BENCH_DEMCR |= (1u << 24);                                               // TRCENA
+    LOGGER_BENCH_DWT_CYCCNT = 0;
+    LOGGER_BENCH_DWT_CTRL |= 1u;                                                    // CYCCNTENA
+}
+
+/**
+ * @brief   Read the cycle counter.
+ */
+static uint64_t LoggerBenchCounter(void) {
+    return LOGGER_BENCH_DWT_CYCCNT;
+}
+
+#else
+
+#include <time.h>
+
+#define LOGGER_BENCH_UNIT                                                           "ns"
+
+static void LoggerBenchInitCounter(void) {
+}
+
+/**
+ * @brief   Read the C11 host clock, in nanoseconds.
+ */
+static uint64_t LoggerBenchCounter(void) {
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    return (uint64_t) now.tv_sec * 1000000000u + (uint64_t) now.tv_nsec;
+}
+
+#endif
+
+/**
+ * @brief Bytes received by the discarding sink, so that the output cannot be optimized away.
+ */
+static volatile uint32_t logger_bench_bytes = 0;
+
+/**
+ * @brief   Discard a log.
+ */
+static void LoggerBenchSink(const uint8_t *p, uint8_t len) {
+    (void) p;
+    logger_bench_bytes += len;
+}
+
+/**
+ * @brief   Print the cost of one case.
+ *
+ * @param[in] name    The name of the case.
+ * @param[in] total   The counter difference over all iterations.
+ * @param[in] best    The lowest counter difference of a single call.
+ */
+static void LoggerBenchReport(const char *name, uint64_t total, uint64_t best) {
+    printf("%-28s %10lu %s/call (best %lu)\n", name, (unsigned long)(total / LOGGER_BENCH_ITERATIONS),
+            LOGGER_BENCH_UNIT, (unsigned long) best);
+}
+
+/**
+ * @brief   Measure a statement, LOGGER_BENCH_ITERATIONS times. The setup runs before every call and is not measured.
+ */
+#define LOGGER_BENCH_CASE(name, setup, statement)                                                   \
+    do {                                                                                            \
+        uint64_t total = 0;                                                                         \
+        uint64_t best = UINT64_MAX;                                                                 \
+        for (uint32_t iteration = 0; iteration < LOGGER_BENCH_ITERATIONS; iteration++) {            \
+            setup;                                                                                  \
+            uint64_t start = LoggerBenchCounter();                                                  \
+            statement;                                                                              \
+            uint64_t elapsed = LoggerBenchCounter() - start;                                        \
+            total += elapsed;                                                                       \
+            best = (elapsed < best) ? elapsed : best;                                               \
+        }                                                                                           \
+        LoggerBenchReport(name, total, best);                                                       \
+    } while (0)
+
+/**
+ * @brief   Run every case of the configured logger mode and print the results.
+ */
+void LoggerBenchRun(void) {
+    LoggerBenchInitCounter();
+    LoggerRegisterAppFunctions(NULL, LoggerBenchSink);
+    SetCurrentLogLevel(INFO);
+
+    LOGGER_BENCH_CASE("empty", (void) 0, (void) 0);
+#if defined(LOGGER_ENABLED)
+    static const char long_text[] =
+            "0123456789abcdefghijklmnopqrstuvwxyz0123456789abcdefghijklmnopqrstuvwxyz"
+            "0123456789abcdefghijklmnopqrstuvwxyz0123456789abcdefghijklmnopqrstuvwxyz"
+            "0123456789abcdefghijklmnopqrstuvwxyz0123456789abcdefghijklmnopqrstuvwxyz"
+            "0123456789abcdefghijklmnopqrstuvwxyz0123456789abcdefghijklmnopqrstuvwxyz";
+
+    LOGGER_BENCH_CASE("filtered out", LOGGER_BENCH_SETUP, LOGGER(DBG, "filtered %d", 1));
+    LOGGER_BENCH_CASE("short", LOGGER_BENCH_SETUP, LOGGER(INFO, "ok"));
+    LOGGER_BENCH_CASE("long, truncated", LOGGER_BENCH_SETUP, LOGGER(INFO, "%s", long_text));
+    LOGGER_BENCH_CASE("many arguments", LOGGER_BENCH_SETUP,
+            LOGGER(INFO, "%d %u %x %ld %c %s %d %u", -1, 2u, 0xABCDu, -4L, 'e', "six", 7, 8u));
+    LOGGER_BENCH_CASE("hexdump of 64 bytes", LOGGER_BENCH_SETUP, LOGGER_HEXDUMP(INFO, long_text, 64));
+    LOGGER_BENCH_CASE("sampled, 1 in 100", LOGGER_BENCH_SETUP, LOGGER_SAMPLED(INFO, 100, "sampled %d", 1));
+#if defined(LOGGER_ISR_ENABLED)
+    // The records are printed by LoggerFlush(), which runs before every call so that the ring never fills up.
+    LOGGER_BENCH_CASE("interrupt, 2 arguments", LoggerFlush(), LOGGER_ISR(INFO, "isr %d %u", -1, 2u));
+#endif
+#if defined(LOGGER_RING)
+    LOGGER_BENCH_CASE("flush of one log", LOGGER(INFO, "ok"), LoggerFlush());
+#endif
+#elif defined(HARD_FAULT_LOGGER_ENABLED)
+    logger_breadcrumb_t trail[1];
+
+    // Start every call from an empty trail, so that no entry is evicted.
+    LOGGER_BENCH_CASE("append", LoggerRecoverCrashLog(trail, 0), LOGGER(ERR, ""));
+    // Fill the trail, so that every entry evicts the oldest one.
+    for (uint32_t entry = 0; entry < LOGGER_BENCH_ITERATIONS; entry++) {
+        LOGGER(ERR, "");
+    }
+    LOGGER_BENCH_CASE("append with eviction", (void) 0, LOGGER(ERR, ""));
+#endif
+    printf("%lu bytes printed\n", (unsigned long) logger_bench_bytes);
+}
+
+#if !defined(LOGGER_BENCH_NO_MAIN)
+
+int main(void) {
+    LoggerBenchRun();
+    return 0;
+}
+
+#endif
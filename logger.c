@@ -7,11 +7,6 @@
 
 #include "logger.h"
 
-/**
- * @brief This variable represents the maximum length that can be logged.
- */
-#define LOGGER_BUFFER_MAX_LENGTH                                						256
-
 /**
  * @brief Size of the application name buffer.
  *
@@ -21,6 +16,73 @@
  */
 #define APP_NAME_SIZE 50
 
+#if defined(HARD_FAULT_LOGGER_ENABLED) && !defined(LOGGER_ENABLED)
+
+/**
+ * @brief Number of entries in the hard fault logger trail.
+ *
+ * @details The entries take the same memory as the logger buffer of the other modes.
+ */
+#define LOGGER_BREADCRUMB_COUNT                                                     ((uint16_t)(LOGGER_BUFFER_MAX_LENGTH / sizeof(logger_breadcrumb_t)))
+
+/**
+ * @brief Marks a trail that has been started by this firmware.
+ */
+#define LOGGER_TRAIL_MAGIC                                                          0x4C4F4754u
+
+/**
+ * @brief Linker section of the hard fault logger trail.
+ *
+ * @details When LOGGER_NOINIT_SECTION is defined in hard fault mode (HARD_FAULT_LOGGER_ENABLED), the trail is placed
+ *          in the given section, e.g. -DLOGGER_NOINIT_SECTION=\".noinit\". The linker script must keep the section
+ *          out of the startup code's zero and copy loops (NOLOAD), so that the trail survives a reset and can be read
+ *          with LoggerRecoverCrashLog() on the next boot.
+ */
+#if defined(LOGGER_NOINIT_SECTION)
+#define LOGGER_NOINIT                                                               __attribute__((section(LOGGER_NOINIT_SECTION)))
+#else
+#define LOGGER_NOINIT
+#endif
+
+/**
+ * @brief Trail of the hard fault logger.
+ *
+ * @details Entries are written by @ref LOG in a circle, head is the next entry to write and count the number of
+ *          valid entries before it. The checksum is the sum of the valid entries and of the head and count, and is
+ *          updated with every entry so that an append stays O(1).
+ */
+typedef struct
+{
+    uint32_t magic;                                                                     /**< LOGGER_TRAIL_MAGIC once started */
+    uint32_t checksum;                                                                  /**< Checksum of the trail */
+    uint16_t head;                                                                      /**< Next entry to write */
+    uint16_t count;                                                                     /**< Number of valid entries */
+    logger_breadcrumb_t entries[LOGGER_BREADCRUMB_COUNT];                               /**< Entries of the trail */
+}logger_trail_t;
+
+/**
+ * @brief Contains the trail of the hard fault logger.
+ *
+ * @details It is not cleared by the startup code when LOGGER_NOINIT_SECTION is defined, see LoggerRecoverCrashLog().
+ */
+static logger_trail_t logger_trail LOGGER_NOINIT;
+
+#elif defined(LOGGER_THREAD_SAFE) && defined(LOGGER_THREAD_LOCAL)
+
+/**
+ * @brief Contains the string form of the logs of the calling thread.
+ */
+static _Thread_local char logger_buffer[LOGGER_BUFFER_MAX_LENGTH];
+
+#elif defined(LOGGER_THREAD_SAFE)
+
+/**
+ * @brief Contain the string form of the logs, one buffer per context returned by the GetContext function.
+ */
+static char logger_buffers[LOGGER_CONTEXT_COUNT][LOGGER_BUFFER_MAX_LENGTH];
+
+#else
+
 /**
  * @brief Contains the string form of the logs.
  *
@@ -28,6 +90,8 @@
  */
 static char logger_buffer[LOGGER_BUFFER_MAX_LENGTH];
 
+#endif
+
 /**
  * @brief Current log level for the application.
  *
@@ -35,7 +99,24 @@ static char logger_buffer[LOGGER_BUFFER_MAX_LENGTH];
  *          It is initialized to WARN, indicating that log messages with a level
  *          of WARN or higher will be printed by default.
  */
-logger_levels_t currentLogLevel = WARN;
+logger_levels_t currentLogLevel = LOGGER_DEFAULT_LEVEL;
+
+/**
+ * @brief Log levels of the module tags, relative to LOGGER_DEFAULT_LEVEL.
+ */
+int8_t tagLogLevels[LOGGER_TAG_COUNT];
+
+/**
+ * @brief Global sampling rate of LOGGER_SAMPLED(), multiplying the period of every sampled call site.
+ */
+uint32_t logSamplingRate = 1;
+
+/**
+ * @brief Lowest of the current log level and the log levels of the module tags.
+ *
+ * @details LOG() drops the logs below it, which can only come from direct calls that bypass LOGGER().
+ */
+static logger_levels_t lowest_log_level = LOGGER_DEFAULT_LEVEL;
 
 /**
  * @brief Buffer to store the application name.
@@ -47,6 +128,15 @@ logger_levels_t currentLogLevel = WARN;
  */
 static char app_name[APP_NAME_SIZE] = "MyApp";
 
+/**
+ * @brief Output profile of the text logs, see SetLogProfile().
+ */
+static logger_profile_t log_profile = LOGGER_PROFILE_FULL;
+
+#if defined(LOGGER_ENABLED) && !defined(LOGGER_TOKENIZED)
+static void LoggerBuildPrefixes(void);
+#endif
+
 /**
  * @brief Function pointer to obtain the elapsed time in milliseconds.
  *
@@ -66,6 +156,182 @@ static GetMillisecondsFunction pfGetMilliseconds = NULL;
  */
 static LoggerPrintfFunction pfLoggerPrintf = NULL;
 
+/**
+ * @brief Function pointer to print log messages of any length.
+ *
+ * @details When it is set, it is used instead of pfLoggerPrintf. The function is typically set by calling
+ *          LoggerRegisterWriteFunction.
+ */
+static LoggerWriteFunction pfLoggerWrite = NULL;
+
+/**
+ * @brief Function pointer to write the FATAL logs synchronously.
+ *
+ * @details When it is set, the FATAL logs and the pending logs bypass the queues and the output lock. The function
+ *          is typically set by calling LoggerRegisterPanicFunction.
+ */
+static LoggerWriteFunction pfLoggerPanic = NULL;
+
+/**
+ * @brief Function pointer to print a log message made of segments.
+ *
+ * @details This function pointer is used to hold the address of a function that prints
+ *          a log message given as an array of segments. When it is set, LOG() uses it instead
+ *          of pfLoggerPrintf. The function is typically set by calling LoggerRegisterWritevFunction.
+ */
+static LoggerWritevFunction pfLoggerWritev = NULL;
+
+/**
+ * @brief An additional output of the logs.
+ */
+typedef struct
+{
+    LoggerPrintfFunction print;                                                         /**< Output function, NULL if unused */
+    logger_levels_t level;                                                              /**< Lowest level printed */
+    bool color;                                                                         /**< Keep the color codes */
+}logger_sink_t;
+
+/**
+ * @brief Additional outputs registered with LoggerAddSink().
+ */
+static logger_sink_t logger_sinks[LOGGER_SINK_COUNT];
+
+/**
+ * @brief Number of registered sinks.
+ */
+static uint8_t logger_sink_count = 0;
+
+/**
+ * @brief Lowest log level wanted by any output, above FATAL if there is no output at all.
+ *
+ * @details LOG() does not format the logs below it, since nobody would print them.
+ */
+static int output_log_level = FATAL + 1;
+
+/**
+ * @brief   Update the lowest log level wanted by any output.
+ *
+ * @details It runs whenever an output is registered, so the log prefixes are also built here when the first output
+ *          comes, before the first log can be formatted. They are not built again for the later outputs, since the
+ *          other threads may be reading them.
+ */
+static void LoggerUpdateOutputLevel(void) {
+    int level = (pfLoggerPrintf != NULL || pfLoggerWrite != NULL || pfLoggerWritev != NULL) ? (int) DBG : FATAL + 1;
+
+    for (size_t sink = 0; sink < LOGGER_SINK_COUNT; sink++) {
+        if (logger_sinks[sink].print != NULL && (int) logger_sinks[sink].level < level) {
+            level = (int) logger_sinks[sink].level;
+        }
+    }
+    if (pfLoggerPanic != NULL && level > (int) FATAL) {
+        level = (int) FATAL;
+    }
+#if defined(LOGGER_ENABLED) && !defined(LOGGER_TOKENIZED)
+    if (output_log_level > (int) FATAL && level <= (int) FATAL) {
+        LoggerBuildPrefixes();
+    }
+#endif
+    output_log_level = level;
+}
+
+/**
+ * @brief Function pointer to obtain the elapsed time as an integer tick count.
+ *
+ * @details This function pointer is used to hold the address of a function that returns
+ *          a monotonic tick count. When it is set, it takes precedence over pfGetMilliseconds.
+ *          The function is typically set by calling LoggerRegisterTicksFunction.
+ */
+static GetTicksFunction pfGetTicks = NULL;
+
+/**
+ * @brief Number of ticks of pfGetTicks in one second.
+ */
+static uint32_t ticks_per_second = 1000;
+
+#if defined(LOGGER_STATS)
+
+/**
+ * @brief Counters of the logger, see LoggerGetStats().
+ */
+static logger_stats_t logger_stats;
+
+/**
+ * @brief   Count an event of the logger.
+ */
+#define LOGGER_STATS_COUNT(counter)                                                 (logger_stats.counter++)
+
+/**
+ * @brief   Read the tick source for the durations of the statistics.
+ *
+ * @return  The tick count, or 0 if no tick source is registered.
+ */
+static inline uint64_t LoggerStatsTicks(void) {
+    return (pfGetTicks != NULL) ? pfGetTicks() : 0;
+}
+
+/**
+ * @brief   Record the duration of a call of LOG().
+ *
+ * @param[in] start   The tick count at the start of the call.
+ */
+static inline void LoggerStatsLog(uint64_t start) {
+    if (pfGetTicks != NULL) {
+        uint64_t ticks = pfGetTicks() - start;
+        logger_stats.log_calls++;
+        logger_stats.log_ticks += ticks;
+        if (ticks > logger_stats.log_max_ticks) {
+            logger_stats.log_max_ticks = (uint32_t)((ticks < UINT32_MAX) ? ticks : UINT32_MAX);
+        }
+    }
+}
+
+/**
+ * @brief   Record the duration of a call of the output function or of a sink.
+ *
+ * @param[in] start   The tick count at the start of the call.
+ */
+static inline void LoggerStatsOutput(uint64_t start) {
+    if (pfGetTicks != NULL) {
+        uint64_t ticks = pfGetTicks() - start;
+        if (ticks > logger_stats.output_max_ticks) {
+            logger_stats.output_max_ticks = (uint32_t)((ticks < UINT32_MAX) ? ticks : UINT32_MAX);
+        }
+    }
+}
+
+#else
+
+#define LOGGER_STATS_COUNT(counter)                                                 ((void) 0)
+
+static inline uint64_t LoggerStatsTicks(void) {
+    return 0;
+}
+
+static inline void LoggerStatsLog(uint64_t start) {
+    (void) start;
+}
+
+static inline void LoggerStatsOutput(uint64_t start) {
+    (void) start;
+}
+
+#endif
+
+#if defined(LOGGER_THREAD_SAFE)
+
+/**
+ * @brief Function pointer to obtain the index of the logger buffer of the calling context.
+ */
+static GetContextFunction pfGetContext = NULL;
+
+/**
+ * @brief Function pointers to serialize the output of the logs.
+ */
+static LoggerLockFunction pfLoggerLock = NULL;
+static LoggerLockFunction pfLoggerUnlock = NULL;
+
+#endif
+
 /**
  * @brief   Get the elapsed time in milliseconds.
  *
@@ -102,6 +368,42 @@ __inline void LoggerPrintf(const uint8_t* p, uint8_t len)
     }
 }
 
+/**
+ * @brief   Print a buffer through a LoggerPrintfFunction, in pieces of at most 255 bytes.
+ *
+ * @param[in] print   The function that prints the pieces.
+ * @param[in] p       A pointer to the buffer.
+ * @param[in] len     The length of the buffer.
+ */
+static void LoggerPrintChunks(LoggerPrintfFunction print, const uint8_t *p, size_t len) {
+    while (len > UINT8_MAX) {
+        print(p, UINT8_MAX);
+        p += UINT8_MAX;
+        len -= UINT8_MAX;
+    }
+    if (len > 0) {
+        print(p, (uint8_t) len);
+    }
+}
+
+/**
+ * @brief   Print a buffer of any length.
+ *
+ * @details The buffer is passed whole to pfLoggerWrite if it is set, otherwise it is streamed to pfLoggerPrintf
+ *          in pieces of at most 255 bytes.
+ *
+ * @param[in] p   A pointer to the buffer.
+ * @param[in] len The length of the buffer.
+ */
+void LoggerWrite(const uint8_t* p, size_t len)
+{
+    if (pfLoggerWrite != NULL) {
+        pfLoggerWrite(p, len);
+    } else if (pfLoggerPrintf != NULL) {
+        LoggerPrintChunks(pfLoggerPrintf, p, len);
+    }
+}
+
 /**
  * @brief   Register application-specific functions for logging and information retrieval.
  *
@@ -117,170 +419,3171 @@ void LoggerRegisterAppFunctions(GetMillisecondsFunction pGetMilliseconds, Logger
 {
     pfGetMilliseconds = pGetMilliseconds;
     pfLoggerPrintf = pLoggerPrintf;
+    LoggerUpdateOutputLevel();
 }
 
 /**
- * @brief   Get the application name.
- *
- * @details This function retrieves the application name through the global
- *          character array `app_name`. It returns a pointer to a constant
- *          character string representing the application name.
+ * @brief   Register an output function that takes logs of any length.
  *
- * @return  A pointer to a constant character string representing the application name.
+ * @param[in] pLoggerWrite   A function pointer to print a log message of any length.
  */
-const char* GetAppName(void) {
-    return app_name;
+void LoggerRegisterWriteFunction(LoggerWriteFunction pLoggerWrite)
+{
+    pfLoggerWrite = pLoggerWrite;
+    LoggerUpdateOutputLevel();
 }
 
 /**
- * @brief   Set the application name.
- *
- * @details This function sets the application name using the provided string `appName`.
- *          It copies the string into the global character array `app_name`, ensuring
- *          it does not exceed the maximum size defined by `sizeof(app_name) - 1`.
- *          The function null-terminates the array to ensure proper string termination.
+ * @brief   Register the emergency output of the FATAL logs.
  *
- * @param[in] appName   A pointer to the string representing the new application name.
+ * @param[in] pPanic   A function pointer to write bytes synchronously.
  */
-void SetAppName(const char* appName) {
-    // Copy the provided string into the global character array, limiting the size.
-    strncpy(app_name, appName, sizeof(app_name) - 1);
-
-    // Null-terminate the array to ensure proper string termination.
-    app_name[sizeof(app_name) - 1] = '\0';
+void LoggerRegisterPanicFunction(LoggerWriteFunction pPanic)
+{
+    pfLoggerPanic = pPanic;
+    LoggerUpdateOutputLevel();
 }
 
 /**
- * @brief   Get the current log level.
+ * @brief   Register a vectored output function.
  *
- * @details This function retrieves the current log level from the global variable
- *          `currentLogLevel` and returns it. If the variable is not set, it defaults
- *          to the debug log level (DBG).
+ * @details When a vectored output function is registered, LOG() passes the pieces of every log to
+ *          it as segments instead of copying them into the logger buffer and calling the LoggerPrintf
+ *          function. Ring, deferred, tokenized and asynchronous modes print complete buffers and keep
+ *          using the LoggerPrintf function. Pass NULL to go back to the LoggerPrintf function.
  *
- * @return  The current log level, typically of the type logger_levels_t.
+ * @param[in] pLoggerWritev   A function pointer to print a log message made of segments.
  */
-logger_levels_t GetCurrentLogLevel(void) {
-    // Retrieve the current log level from the global variable.
-    return currentLogLevel;
+void LoggerRegisterWritevFunction(LoggerWritevFunction pLoggerWritev)
+{
+    pfLoggerWritev = pLoggerWritev;
+    LoggerUpdateOutputLevel();
 }
 
 /**
- * @brief   Set the current log level.
+ * @brief   Register an additional output of the logs.
  *
- * @details This function sets the current log level to the specified value `level`
- *          in the global variable `currentLogLevel`.
+ * @param[in] pPrint   A function pointer to print a log.
+ * @param[in] level    The lowest log level printed by the sink.
+ * @param[in] color    true to keep the color codes of the logs, false to remove them.
  *
- * @param[in] level   The new log level to be set, typically of the type logger_levels_t.
+ * @return  The id of the sink, or -1 if LOGGER_SINK_COUNT sinks are registered already.
  */
-void SetCurrentLogLevel(logger_levels_t level) {
-    // Set the current log level to the specified value.
-    currentLogLevel = level;
+int LoggerAddSink(LoggerPrintfFunction pPrint, logger_levels_t level, bool color)
+{
+    if (pPrint == NULL) {
+        return -1;
+    }
+    for (int sink = 0; sink < LOGGER_SINK_COUNT; sink++) {
+        if (logger_sinks[sink].print == NULL) {
+            logger_sinks[sink].level = level;
+            logger_sinks[sink].color = color;
+            logger_sinks[sink].print = pPrint;
+            logger_sink_count++;
+            LoggerUpdateOutputLevel();
+            return sink;
+        }
+    }
+    return -1;
 }
 
 /**
- * @brief   Retrieve the current content of the logger buffer.
- *
- * @details This function copies the current content of the logger buffer into
- *          the provided buffer. The logger buffer stores formatted log messages
- *          and related information.
+ * @brief   Change the lowest log level printed by a sink.
  *
- * @param[out] buffer   A pointer to the buffer where the logger content will be copied.
+ * @param[in] sink    The id returned by LoggerAddSink().
+ * @param[in] level   The lowest log level printed by the sink.
  */
-void GetLoggerBuffer(char *buffer) {
-    // Copy the content of the logger buffer into the provided buffer.
-    memcpy(buffer, &logger_buffer, sizeof(logger_buffer));
+void LoggerSetSinkLevel(int sink, logger_levels_t level)
+{
+    if (sink < 0 || sink >= LOGGER_SINK_COUNT) {
+        return;
+    }
+    logger_sinks[sink].level = level;
+    LoggerUpdateOutputLevel();
 }
 
 /**
- * @brief   Extracts the file name from a given file path.
- *
- * @details This function takes a file path as input and identifies the last occurrence
- *          of '/' or '\\' to determine the file name. It returns a pointer to the substring
- *          containing the file name.
+ * @brief   Unregister a sink.
  *
- * @param[in] path A pointer to the file path string.
- *
- * @return  A pointer to the substring containing the file name, or the original path if
- *          no separator ('/' or '\\') is found.
+ * @param[in] sink   The id returned by LoggerAddSink().
  */
-static const char* GetFileNameFromPath(const char* path) {
-    // Find the last occurrence of '/' or '\\' in the path
-    const char* lastSlash = strrchr(path, '/');
-    const char* lastBackslash = strrchr(path, '\\');
+void LoggerRemoveSink(int sink)
+{
+    if (sink < 0 || sink >= LOGGER_SINK_COUNT || logger_sinks[sink].print == NULL) {
+        return;
+    }
+    logger_sinks[sink].print = NULL;
+    logger_sink_count--;
+    LoggerUpdateOutputLevel();
+}
 
-    // Choose the last occurrence as the separator
-    const char* lastSeparator = (lastSlash > lastBackslash) ? lastSlash : lastBackslash;
+#if defined(LOGGER_FLASH)
 
-    // If a separator is found, return the substring after it; otherwise, return the whole path
-    return (lastSeparator != NULL) ? lastSeparator + 1 : path;
-}
+/**
+ * @brief Magic number at the start of every sector of the log store ("LOGF").
+ */
+#define LOGGER_FLASH_MAGIC                                                          0x464F474Cu
 
-#if defined(LOGGER_ENABLED)
+/**
+ * @brief Size of the sector header: magic number and sequence number, both little-endian.
+ */
+#define LOGGER_FLASH_HEADER_SIZE                                                    8u
 
 /**
- * @brief Macro for adding an entity to the description array.
- *
- * Macro that helps to create a single entity in the description array.
+ * @brief Size of the length that precedes every record. A length of 0xFFFF is erased flash.
  */
-#define LOGGER_ENTITY(mnemonic)                                							{.level=mnemonic, .name=#mnemonic}
+#define LOGGER_FLASH_LENGTH_SIZE                                                    2u
 
 /**
- *  Macro element that describes an log level. @ref LOGGER_ENTITY
+ * @brief Flash area of the log store, NULL before LoggerFlashInit().
  */
-typedef struct{
-    logger_levels_t level;                                                      		/**< Log level */
-    char const * name;                                                                  /**< Log level name */
-}logger_entity_t;
+static const logger_flash_t *logger_flash = NULL;
 
 /**
- * @brief Array entity element that describes an log.
+ * @brief Page being filled, programmed when it is full.
  */
-typedef struct
-{
-    logger_entity_t entity;                                                     		/**< @ref ogger_entity_t */
-    char const * color;                                                                 /**< Log level color code */
-}logger_desc_t;
+static uint8_t logger_flash_page[LOGGER_FLASH_PAGE_SIZE];
 
 /**
- * @brief Array with log level codes.
+ * @brief Number of bytes of the page being filled.
+ */
+static uint16_t logger_flash_fill = 0;
+
+/**
+ * @brief Sector being written, its sequence number and the offset of the page being filled in it.
  *
- * Array that describes log levels.
+ * @details An offset of sector_size means that the next write starts a new sector.
+ */
+static uint16_t logger_flash_sector = 0;
+static uint32_t logger_flash_sequence = 0;
+static uint32_t logger_flash_offset = 0;
+
+/**
+ * @brief Number of failed erases and programs since LoggerFlashInit(), see LoggerFlashErrors().
+ */
+static uint32_t logger_flash_errors = 0;
+
+/**
+ * @brief Whether the store has stopped because no sector could be erased.
+ */
+static bool logger_flash_stopped = false;
+
+/**
+ * @brief   Read a little-endian 32-bit value.
+ */
+static uint32_t LoggerFlashWord(const uint8_t *p) {
+    return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+/**
+ * @brief   Get the address of an offset in a sector.
+ */
+static uint32_t LoggerFlashAddress(uint16_t sector, uint32_t offset) {
+    return logger_flash->address + (uint32_t) sector * logger_flash->sector_size + offset;
+}
+
+/**
+ * @brief   Read the sequence number of a sector.
+ *
+ * @param[in]  sector     The sector.
+ * @param[out] sequence   The sequence number of the sector.
+ *
+ * @return  true if the sector has a valid header, false if it is erased or unused.
+ */
+static bool LoggerFlashSectorSequence(uint16_t sector, uint32_t *sequence) {
+    uint8_t header[LOGGER_FLASH_HEADER_SIZE];
+
+    if (!logger_flash->read(LoggerFlashAddress(sector, 0), header, sizeof(header)) ||
+            LoggerFlashWord(header) != LOGGER_FLASH_MAGIC) {
+        return false;
+    }
+    *sequence = LoggerFlashWord(header + 4);
+    return true;
+}
+
+/**
+ * @brief   Program the page being filled, the unused bytes left erased.
+ *
+ * @details If the page cannot be programmed, its logs are lost and the sector is closed, so that nothing is
+ *          programmed after a page in an unknown state. The next log starts a new sector.
+ */
+static void LoggerFlashProgramPage(void) {
+    if (logger_flash_fill == 0) {
+        return;
+    }
+    memset(logger_flash_page + logger_flash_fill, 0xFF, logger_flash->page_size - logger_flash_fill);
+    if (logger_flash->program(LoggerFlashAddress(logger_flash_sector, logger_flash_offset), logger_flash_page,
+            logger_flash->page_size)) {
+        logger_flash_offset += logger_flash->page_size;
+    } else {
+        logger_flash_errors++;
+        logger_flash_offset = logger_flash->sector_size;
+    }
+    logger_flash_fill = 0;
+}
+
+/**
+ * @brief   Erase the next sector, which holds the oldest logs, and start filling it.
+ *
+ * @details A sector that cannot be erased is skipped and never programmed. If no sector can be erased, the store
+ *          stops.
+ *
+ * @return  true if a sector was erased, false if the store has stopped.
+ */
+static bool LoggerFlashNextSector(void) {
+    for (uint16_t attempt = 0; attempt < logger_flash->sector_count; attempt++) {
+        logger_flash_sector = (uint16_t)((logger_flash_sector + 1) % logger_flash->sector_count);
+        if (!logger_flash->erase(LoggerFlashAddress(logger_flash_sector, 0))) {
+            logger_flash_errors++;
+            continue;
+        }
+        logger_flash_sequence++;
+        logger_flash_offset = 0;
+        // The header is programmed with the first page.
+        const uint32_t header[2] = { LOGGER_FLASH_MAGIC, logger_flash_sequence };
+        for (uint16_t index = 0; index < LOGGER_FLASH_HEADER_SIZE; index++) {
+            logger_flash_page[index] = (uint8_t)(header[index / 4] >> (8 * (index % 4)));
+        }
+        logger_flash_fill = LOGGER_FLASH_HEADER_SIZE;
+        return true;
+    }
+    logger_flash_stopped = true;
+    return false;
+}
+
+/**
+ * @brief   Append bytes to the page being filled, programming it whenever it is full.
+ */
+static void LoggerFlashPut(const uint8_t *p, size_t len) {
+    while (len > 0 && logger_flash_offset < logger_flash->sector_size) {
+        size_t length = logger_flash->page_size - logger_flash_fill;
+        length = (len < length) ? len : length;
+        memcpy(logger_flash_page + logger_flash_fill, p, length);
+        logger_flash_fill = (uint16_t)(logger_flash_fill + length);
+        p += length;
+        len -= length;
+        if (logger_flash_fill == logger_flash->page_size) {
+            LoggerFlashProgramPage();
+        }
+    }
+}
+
+/**
+ * @brief   Sink of the log store: append a log as one record.
+ *
+ * @details The length of a record never straddles two pages, so that a reader can tell it from the erased end
+ *          of a page programmed by LoggerFlashSync(). A record never straddles two sectors.
+ */
+static void LoggerFlashSink(const uint8_t *p, uint8_t len) {
+    if (logger_flash == NULL || logger_flash_stopped || len == 0) {
+        return;
+    }
+    if ((uint32_t)(logger_flash->page_size - logger_flash_fill) < LOGGER_FLASH_LENGTH_SIZE) {
+        LoggerFlashProgramPage();
+    }
+    if (logger_flash_offset + logger_flash_fill + LOGGER_FLASH_LENGTH_SIZE + len > logger_flash->sector_size) {
+        LoggerFlashProgramPage();
+        logger_flash_offset = logger_flash->sector_size;
+    }
+    if (logger_flash_offset >= logger_flash->sector_size && !LoggerFlashNextSector()) {
+        return;
+    }
+    const uint8_t length[LOGGER_FLASH_LENGTH_SIZE] = { len, 0 };
+    LoggerFlashPut(length, sizeof(length));
+    LoggerFlashPut(p, len);
+}
+
+/**
+ * @brief   Check if a page of the sector being written is erased.
+ */
+static bool LoggerFlashPageErased(uint32_t page) {
+    if (!logger_flash->read(LoggerFlashAddress(logger_flash_sector, page * logger_flash->page_size),
+            logger_flash_page, logger_flash->page_size)) {
+        return false;
+    }
+    for (uint16_t index = 0; index < logger_flash->page_size; index++) {
+        if (logger_flash_page[index] != 0xFF) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief   Mount the flash log store and register its sink.
+ *
+ * @param[in] flash   The flash area, which must stay valid while the store is used.
+ * @param[in] level   The lowest log level stored.
+ *
+ * @return  false if the geometry is invalid or no sink could be registered, true otherwise.
+ */
+bool LoggerFlashInit(const logger_flash_t *flash, logger_levels_t level)
+{
+    if (flash == NULL || flash->erase == NULL || flash->program == NULL || flash->read == NULL ||
+            flash->sector_count < 2 || flash->page_size < 16 || flash->page_size > LOGGER_FLASH_PAGE_SIZE ||
+            flash->sector_size < 512 || flash->sector_size % flash->page_size != 0) {
+        return false;
+    }
+    bool registered = (logger_flash != NULL);
+    logger_flash = flash;
+    logger_flash_fill = 0;
+    logger_flash_errors = 0;
+    logger_flash_stopped = false;
+
+    // The newest sector has the highest sequence number. Without any, the first log erases sector 0.
+    bool found = false;
+    logger_flash_sector = (uint16_t)(flash->sector_count - 1);
+    logger_flash_sequence = 0;
+    for (uint16_t sector = 0; sector < flash->sector_count; sector++) {
+        uint32_t sequence;
+        if (LoggerFlashSectorSequence(sector, &sequence) && (!found || sequence > logger_flash_sequence)) {
+            found = true;
+            logger_flash_sector = sector;
+            logger_flash_sequence = sequence;
+        }
+    }
+    logger_flash_offset = flash->sector_size;
+    if (found) {
+        // The pages are programmed in order, so the first erased page is found by a binary search. The first
+        // page holds the header and is never erased.
+        uint32_t first = 1;
+        uint32_t last = flash->sector_size / flash->page_size;
+        while (first < last) {
+            uint32_t page = first + (last - first) / 2;
+            if (LoggerFlashPageErased(page)) {
+                last = page;
+            } else {
+                first = page + 1;
+            }
+        }
+        logger_flash_offset = first * flash->page_size;
+    }
+    if (!registered && LoggerAddSink(LoggerFlashSink, level, false) < 0) {
+        logger_flash = NULL;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief   Program the page being filled, even if it is not full.
+ */
+void LoggerFlashSync(void)
+{
+    if (logger_flash != NULL) {
+        LoggerFlashProgramPage();
+    }
+}
+
+/**
+ * @brief   Get the number of failed erases and programs of the flash since LoggerFlashInit().
+ *
+ * @return  The number of failures.
+ */
+uint32_t LoggerFlashErrors(void)
+{
+    return logger_flash_errors;
+}
+
+/**
+ * @brief   Start reading the log store from its oldest record.
+ *
+ * @param[out] iterator   The reader position.
+ */
+void LoggerFlashIterate(logger_flash_iterator_t *iterator)
+{
+    // The sectors are written in turn, so the oldest one follows the newest one.
+    iterator->sector = 0;
+    iterator->remaining = 0;
+    iterator->offset = 0;
+    if (logger_flash != NULL) {
+        iterator->sector = (uint16_t)((logger_flash_sector + 1) % logger_flash->sector_count);
+        iterator->remaining = (uint16_t)(logger_flash->sector_count - 1);
+    }
+}
+
+/**
+ * @brief   Read the next record of the log store.
+ *
+ * @param[in,out] iterator   The reader position, started by LoggerFlashIterate().
+ * @param[out]    buffer     The buffer that receives the record.
+ * @param[in]     size       The size of the buffer.
+ *
+ * @return  The length of the record copied into the buffer, or 0 after the newest record.
+ */
+uint16_t LoggerFlashNext(logger_flash_iterator_t *iterator, uint8_t *buffer, uint16_t size)
+{
+    if (logger_flash == NULL) {
+        return 0;
+    }
+    const uint32_t page_size = logger_flash->page_size;
+    const uint32_t sector_size = logger_flash->sector_size;
+    for (;;) {
+        uint32_t offset = iterator->offset;
+        // Only the programmed pages of the sector being written are read.
+        uint32_t limit = (iterator->sector == logger_flash_sector) ? logger_flash_offset : sector_size;
+        uint8_t length[LOGGER_FLASH_LENGTH_SIZE];
+        uint32_t sequence;
+        bool end = false;
+
+        if (offset == 0) {
+            // Skip the sectors that have never been written.
+            end = !LoggerFlashSectorSequence(iterator->sector, &sequence);
+            offset = LOGGER_FLASH_HEADER_SIZE;
+        }
+        if (!end && page_size - offset % page_size < LOGGER_FLASH_LENGTH_SIZE) {
+            offset += page_size - offset % page_size;
+        }
+        end = end || offset + LOGGER_FLASH_LENGTH_SIZE > limit ||
+                !logger_flash->read(LoggerFlashAddress(iterator->sector, offset), length, sizeof(length));
+        if (!end) {
+            uint16_t record = (uint16_t)(length[0] | (length[1] << 8));
+            if (record == 0xFFFF) {
+                // Erased: the rest of a page programmed by LoggerFlashSync(), or the end of the sector.
+                if (offset % page_size != 0) {
+                    iterator->offset = offset + page_size - offset % page_size;
+                    continue;
+                }
+                end = true;
+            } else if (record != 0 && offset + LOGGER_FLASH_LENGTH_SIZE + record <= limit) {
+                uint16_t copied = (record < size) ? record : size;
+                iterator->offset = offset + LOGGER_FLASH_LENGTH_SIZE + record;
+                if (!logger_flash->read(LoggerFlashAddress(iterator->sector, offset + LOGGER_FLASH_LENGTH_SIZE),
+                        buffer, copied)) {
+                    return 0;
+                }
+                return copied;
+            } else {
+                end = true;
+            }
+        }
+        if (iterator->remaining == 0) {
+            iterator->offset = sector_size;
+            return 0;
+        }
+        iterator->sector = (uint16_t)((iterator->sector + 1) % logger_flash->sector_count);
+        iterator->remaining--;
+        iterator->offset = 0;
+    }
+}
+
+#endif
+
+/**
+ * @brief   Register an integer tick source for the timestamps of the logs.
+ *
+ * @details When a tick source is registered, it is used instead of the GetMilliseconds function and
+ *          the timestamps are formatted with integer arithmetic only, so neither float arithmetic
+ *          nor float printf support is needed. Pass NULL to go back to the GetMilliseconds function.
+ *
+ * @param[in] pGetTicks        A function pointer to obtain the tick count.
+ * @param[in] ticksPerSecond   The number of ticks in one second, e.g. 1000000 for a microsecond counter or 32768
+ *                             for a watch crystal. It is ignored with NULL.
+ *
+ * @return  true on success, false if the rate is 0, in which case the previous tick source is kept.
+ */
+bool LoggerRegisterTicksFunction(GetTicksFunction pGetTicks, uint32_t ticksPerSecond)
+{
+    if (pGetTicks != NULL && ticksPerSecond == 0) {
+        return false;
+    }
+    if (pGetTicks != NULL) {
+        ticks_per_second = ticksPerSecond;
+    }
+    pfGetTicks = pGetTicks;
+    return true;
+}
+
+#if defined(LOGGER_THREAD_SAFE)
+
+/**
+ * @brief   Register the functions of thread-safe mode.
+ *
+ * @param[in] pGetContext   A function pointer to obtain the index of the calling context, e.g. the core number.
+ *                          It is not used with LOGGER_THREAD_LOCAL.
+ * @param[in] pLock         A function pointer to take the output lock, or NULL.
+ * @param[in] pUnlock       A function pointer to release the output lock, or NULL.
+ */
+void LoggerRegisterThreadFunctions(GetContextFunction pGetContext, LoggerLockFunction pLock, LoggerLockFunction pUnlock)
+{
+    pfGetContext = pGetContext;
+    pfLoggerLock = pLock;
+    pfLoggerUnlock = pUnlock;
+}
+
+#endif
+
+#if !defined(HARD_FAULT_LOGGER_ENABLED) || defined(LOGGER_ENABLED)
+
+/**
+ * @brief   Get the logger buffer of the calling context.
+ *
+ * @details In thread-safe mode (LOGGER_THREAD_SAFE) every thread or context formats its logs in its own buffer, so
+ *          that only the output has to be serialized. Otherwise there is a single logger buffer.
+ *
+ * @return  A pointer to the logger buffer, of LOGGER_BUFFER_MAX_LENGTH characters.
+ */
+static char* LoggerBuffer(void) {
+#if defined(LOGGER_THREAD_SAFE) && !defined(LOGGER_THREAD_LOCAL)
+    uint8_t context = (pfGetContext != NULL) ? pfGetContext() : 0;
+    // Share the first buffer rather than write outside of the buffers.
+    return logger_buffers[(context < LOGGER_CONTEXT_COUNT) ? context : 0];
+#else
+    return logger_buffer;
+#endif
+}
+
+#endif
+
+/**
+ * @brief   Convert a count of the registered tick source into microseconds.
+ *
+ * @param[in] ticks   The tick count.
+ *
+ * @return  The tick count in microseconds.
+ */
+static uint64_t LoggerTicksToMicroseconds(uint64_t ticks) {
+    // Split the conversion so that large tick counts do not overflow, the remainder times 10^6 fits into 52 bits.
+    return (ticks / ticks_per_second) * 1000000u + ((ticks % ticks_per_second) * 1000000u) / ticks_per_second;
+}
+
+/**
+ * @brief   Get the elapsed time in microseconds.
+ *
+ * @details This function converts the registered tick source into microseconds. If no tick source is
+ *          registered, it converts the value of GetMilliseconds() instead.
+ *
+ * @return  The elapsed time in microseconds, or LOGGER_TIMESTAMP_INVALID if no time source is registered.
+ */
+uint64_t GetMicroseconds(void)
+{
+    if (pfGetTicks != NULL) {
+        return LoggerTicksToMicroseconds(pfGetTicks());
+    }
+    if (pfGetMilliseconds != NULL) {
+        float milliseconds = pfGetMilliseconds();
+        return (milliseconds > 0.0f) ? (uint64_t)(milliseconds * 1000.0f) : 0;
+    }
+    return LOGGER_TIMESTAMP_INVALID;
+}
+
+/**
+ * @brief   Check if a rate-limited call site may print a log.
+ *
+ * @param[in,out] limit        The state of the call site.
+ * @param[in]     per_second   The number of logs allowed per second.
+ * @param[out]    suppressed   The number of logs to report as suppressed before this one, usually 0.
+ *
+ * @return  true if the log may be printed, false if it must be dropped.
+ */
+bool LoggerRateLimit(logger_ratelimit_t *limit, uint32_t per_second, uint32_t *suppressed) {
+    uint64_t now = GetMicroseconds();
+
+    *suppressed = 0;
+    // Without a time source there are no windows to count in.
+    if (now == LOGGER_TIMESTAMP_INVALID) {
+        return true;
+    }
+    // Start a new window on the first log and once a second has passed.
+    if (!limit->started || now - limit->window >= 1000000u) {
+        limit->started = true;
+        limit->window = now;
+        limit->count = 0;
+    }
+    if (limit->count >= per_second) {
+        limit->suppressed++;
+        return false;
+    }
+    limit->count++;
+    // Hand the count over only with a log that is printed, so that it is never lost.
+    *suppressed = limit->suppressed;
+    limit->suppressed = 0;
+    return true;
+}
+
+#if defined(LOGGER_STATS)
+
+/**
+ * @brief   Count a log below the log level, called by the logging macros.
+ *
+ * @param[in] level   Log level.
+ */
+void LoggerStatsFiltered(int level)
+{
+    if (level >= (int) DBG && level <= (int) FATAL) {
+        logger_stats.filtered[level]++;
+    }
+}
+
+/**
+ * @brief   Copy the counters of the logger.
+ *
+ * @param[out] stats   The counters.
+ */
+void LoggerGetStats(logger_stats_t *stats)
+{
+    memcpy(stats, &logger_stats, sizeof(logger_stats));
+}
+
+/**
+ * @brief   Reset the counters of the logger.
+ */
+void LoggerResetStats(void)
+{
+    memset(&logger_stats, 0, sizeof(logger_stats));
+}
+
+#endif
+
+/**
+ * @brief   Get the application name.
+ *
+ * @details This function retrieves the application name through the global
+ *          character array `app_name`. It returns a pointer to a constant
+ *          character string representing the application name.
+ *
+ * @return  A pointer to a constant character string representing the application name.
+ */
+const char* GetAppName(void) {
+    return app_name;
+}
+
+/**
+ * @brief   Set the application name.
+ *
+ * @details This function sets the application name using the provided string `appName`.
+ *          It copies the string into the global character array `app_name`, ensuring
+ *          it does not exceed the maximum size defined by `sizeof(app_name) - 1`.
+ *          The function null-terminates the array to ensure proper string termination.
+ *
+ * @param[in] appName   A pointer to the string representing the new application name.
+ */
+void SetAppName(const char* appName) {
+    // Copy the provided string into the global character array, limiting the size.
+    strncpy(app_name, appName, sizeof(app_name) - 1);
+
+    // Null-terminate the array to ensure proper string termination.
+    app_name[sizeof(app_name) - 1] = '\0';
+#if defined(LOGGER_ENABLED) && !defined(LOGGER_TOKENIZED)
+    // Render the application name into the log prefixes once instead of for every log.
+    LoggerBuildPrefixes();
+#endif
+}
+
+/**
+ * @brief   Get the output profile of the text logs.
+ *
+ * @return  The current output profile.
+ */
+logger_profile_t GetLogProfile(void) {
+    return log_profile;
+}
+
+/**
+ * @brief   Set the output profile of the text logs.
+ *
+ * @param[in] profile   The new output profile. Unknown values are ignored.
+ */
+void SetLogProfile(logger_profile_t profile) {
+    if (profile > LOGGER_PROFILE_BARE) {
+        return;
+    }
+    log_profile = profile;
+#if defined(LOGGER_ENABLED) && !defined(LOGGER_TOKENIZED)
+    // Render the parts of the profile into the log prefixes once instead of for every log.
+    LoggerBuildPrefixes();
+#endif
+}
+
+/**
+ * @brief   Get the current log level.
+ *
+ * @details This function retrieves the current log level from the global variable
+ *          `currentLogLevel` and returns it. If the variable is not set, it defaults
+ *          to the debug log level (DBG).
+ *
+ * @return  The current log level, typically of the type logger_levels_t.
+ */
+logger_levels_t GetCurrentLogLevel(void) {
+    // Retrieve the current log level from the global variable.
+    return currentLogLevel;
+}
+
+/**
+ * @brief   Set the current log level.
+ *
+ * @details This function sets the current log level to the specified value `level`
+ *          in the global variable `currentLogLevel`.
+ *
+ * @param[in] level   The new log level to be set, typically of the type logger_levels_t.
+ */
+void SetCurrentLogLevel(logger_levels_t level) {
+    // Set the current log level to the specified value.
+    currentLogLevel = level;
+    for (size_t tag = 0; tag < LOGGER_TAG_COUNT; tag++) {
+        tagLogLevels[tag] = (int8_t)(level - LOGGER_DEFAULT_LEVEL);
+    }
+    lowest_log_level = level;
+}
+
+/**
+ * @brief   Get the global sampling rate of LOGGER_SAMPLED().
+ *
+ * @return  The global sampling rate.
+ */
+uint32_t GetLogSamplingRate(void) {
+    return logSamplingRate;
+}
+
+/**
+ * @brief   Set the global sampling rate of LOGGER_SAMPLED().
+ *
+ * @param[in] rate   The new global sampling rate, 0 to skip every sampled log.
+ */
+void SetLogSamplingRate(uint32_t rate) {
+    logSamplingRate = rate;
+}
+
+/**
+ * @brief   Get the log level of a module tag.
+ *
+ * @param[in] tag   The module tag, below LOGGER_TAG_COUNT.
+ *
+ * @return  The log level of the tag, or the current log level if the tag is out of range.
+ */
+logger_levels_t GetTagLogLevel(uint8_t tag) {
+    if (tag >= LOGGER_TAG_COUNT) {
+        return currentLogLevel;
+    }
+    return (logger_levels_t)(LOGGER_DEFAULT_LEVEL + tagLogLevels[tag]);
+}
+
+/**
+ * @brief   Set the log level of a module tag.
+ *
+ * @param[in] tag     The module tag, below LOGGER_TAG_COUNT. Other values are ignored.
+ * @param[in] level   The new log level of the tag.
+ */
+void SetTagLogLevel(uint8_t tag, logger_levels_t level) {
+    if (tag >= LOGGER_TAG_COUNT) {
+        return;
+    }
+    tagLogLevels[tag] = (int8_t)(level - LOGGER_DEFAULT_LEVEL);
+    // Keep the check of LOG() open for the most verbose tag.
+    lowest_log_level = currentLogLevel;
+    for (size_t index = 0; index < LOGGER_TAG_COUNT; index++) {
+        if (LOGGER_DEFAULT_LEVEL + tagLogLevels[index] < (int) lowest_log_level) {
+            lowest_log_level = (logger_levels_t)(LOGGER_DEFAULT_LEVEL + tagLogLevels[index]);
+        }
+    }
+}
+
+/**
+ * @brief   Retrieve the current content of the logger buffer.
+ *
+ * @details This function copies the current content of the logger buffer into
+ *          the provided buffer. The logger buffer stores formatted log messages
+ *          and related information.
+ *
+ * @param[out] buffer   A pointer to the buffer where the logger content will be copied.
+ */
+void GetLoggerBuffer(char *buffer) {
+#if defined(HARD_FAULT_LOGGER_ENABLED) && !defined(LOGGER_ENABLED)
+    // Unroll the trail so that the oldest entry comes first, and clear the unused entries.
+    // Copy nothing from a trail that has not been started yet.
+    uint16_t count = (logger_trail.magic == LOGGER_TRAIL_MAGIC && logger_trail.head < LOGGER_BREADCRUMB_COUNT &&
+                      logger_trail.count <= LOGGER_BREADCRUMB_COUNT) ? logger_trail.count : 0;
+    size_t oldest = (logger_trail.head + LOGGER_BREADCRUMB_COUNT - count) % LOGGER_BREADCRUMB_COUNT;
+    size_t first = LOGGER_BREADCRUMB_COUNT - oldest;
+    if (first > count) {
+        first = count;
+    }
+    memcpy(buffer, &logger_trail.entries[oldest], first * sizeof(logger_breadcrumb_t));
+    memcpy(buffer + first * sizeof(logger_breadcrumb_t), logger_trail.entries, (count - first) * sizeof(logger_breadcrumb_t));
+    memset(buffer + count * sizeof(logger_breadcrumb_t), 0x00, (LOGGER_BREADCRUMB_COUNT - count) * sizeof(logger_breadcrumb_t));
+#else
+    // Copy the content of the logger buffer into the provided buffer.
+    memcpy(buffer, LoggerBuffer(), LOGGER_BUFFER_MAX_LENGTH);
+#endif
+}
+
+#if defined(LOGGER_ENABLED)
+
+/**
+ * @brief   Extracts the file name from a given file path.
+ *
+ * @details LOGGER() calls it at most once per call site, see LOGGER_FILE_NAME().
+ */
+const char* GetFileNameFromPath(const char* path) {
+    // Find the last occurrence of '/' or '\\' in the path
+    const char* lastSlash = strrchr(path, '/');
+    const char* lastBackslash = strrchr(path, '\\');
+
+    // Choose the last occurrence as the separator
+    const char* lastSeparator = (lastSlash > lastBackslash) ? lastSlash : lastBackslash;
+
+    // If a separator is found, return the substring after it; otherwise, return the whole path
+    return (lastSeparator != NULL) ? lastSeparator + 1 : path;
+}
+
+/**
+ * @brief Macro for adding an entity to the description array.
+ *
+ * Macro that helps to create a single entity in the description array.
+ */
+#define LOGGER_ENTITY(mnemonic)                                							{.level=mnemonic, .name=#mnemonic}
+
+/**
+ *  Macro element that describes an log level. @ref LOGGER_ENTITY
+ */
+typedef struct{
+    logger_levels_t level;                                                      		/**< Log level */
+    char const * name;                                                                  /**< Log level name */
+}logger_entity_t;
+
+/**
+ * @brief Array entity element that describes an log.
+ */
+typedef struct
+{
+    logger_entity_t entity;                                                     		/**< @ref ogger_entity_t */
+    char const * color;                                                                 /**< Log level color code */
+}logger_desc_t;
+
+#if !defined(LOGGER_TOKENIZED)
+
+/**
+ * @brief Array with log level codes.
+ *
+ * Array that describes log levels.
+ *
+ * @note Log levels do not need to be in ascending order in this string.
+ *       This is checked in automated unit testing prior to release.
+ */
+static logger_desc_t const logger_array[] = {
+    {
+        .entity = LOGGER_ENTITY(DBG),
+        .color = "\x1b[37;1m" ///< White color for DEBUG log level.
+    },
+    {
+        .entity = LOGGER_ENTITY(INFO),
+        .color = "\x1b[32;1m" ///< Green color for INFO log level.
+    },
+    {
+        .entity = LOGGER_ENTITY(WARN),
+        .color = "\x1b[33;1m" ///< Yellow color for WARN log level.
+    },
+    {
+        .entity = LOGGER_ENTITY(ERR),
+        .color = "\x1b[31;1m" ///< Red color for ERR log level.
+    },
+    {
+        .entity = LOGGER_ENTITY(FATAL),
+        .color = "\x1b[31;1m" ///< Red color for FATAL log level.
+    }
+};
+
+/**
+ * @brief Number of log levels in the description array.
+ */
+#define LOGGER_LEVEL_COUNT                                                          (sizeof(logger_array) / sizeof(logger_array[0]))
+
+/**
+ * @brief Constant parts of the default log syntax of a log level.
+ */
+typedef struct
+{
+    char prefix[APP_NAME_SIZE + 16];                                                    /**< Color, application name and '[' */
+    uint8_t prefix_length;                                                              /**< Length of the prefix */
+    char level[16];                                                                     /**< "] : ", level name and " : " */
+    uint8_t level_length;                                                               /**< Length of the level part */
+}logger_prefix_t;
+
+/**
+ * @brief Cached constant parts of the default log syntax, see LoggerBuildPrefixes().
+ */
+static logger_prefix_t logger_prefixes[LOGGER_LEVEL_COUNT];
+
+#endif
+
+/**
+ * @brief A literal string containing the color reset and newline characters.
+ */
+const char RESET_NEWLINE[] = "\n\r\x1b[0m";
+
+/**
+ * @brief Length of the color reset at the end of RESET_NEWLINE.
+ */
+#define LOGGER_COLOR_RESET_LENGTH                                                   4
+
+/**
+ * @brief Number of characters of RESET_NEWLINE, without the null terminator.
+ */
+#define RESET_NEWLINE_LENGTH                                                        (sizeof(RESET_NEWLINE) - 1)
+
+/**
+ * @brief   Get the length of the end of a log in the current output profile: the newline, then the color reset if
+ *          the profile has colors.
+ *
+ * @return  The number of characters of RESET_NEWLINE that end a log.
+ */
+static inline size_t LoggerNewlineLength(void) {
+    return (log_profile == LOGGER_PROFILE_FULL) ? RESET_NEWLINE_LENGTH :
+            RESET_NEWLINE_LENGTH - LOGGER_COLOR_RESET_LENGTH;
+}
+
+#if defined(LOGGER_TINY_PRINTF) && !defined(LOGGER_TOKENIZED)
+
+#include <stddef.h>
+#if defined(LOGGER_TINY_PRINTF_FLOAT)
+#include <math.h>
+#endif
+
+/**
+ * @brief Output state of the built-in formatter.
+ */
+typedef struct
+{
+    char *buffer;                                                                       /**< Destination buffer */
+    size_t size;                                                                        /**< Size of the destination */
+    size_t length;                                                                      /**< Characters produced so far */
+}logger_output_t;
+
+/**
+ * @brief Flags of a conversion specification of the built-in formatter.
+ */
+#define LOGGER_FLAG_LEFT                                                            0x01
+#define LOGGER_FLAG_ZERO                                                            0x02
+#define LOGGER_FLAG_PLUS                                                            0x04
+#define LOGGER_FLAG_SPACE                                                           0x08
+#define LOGGER_FLAG_UPPER                                                           0x10
+
+/**
+ * @brief   Append a character to the output, counting it even if the buffer is full.
+ *
+ * @param[in,out] output      The output state.
+ * @param[in]     character   The character to append.
+ */
+static void LoggerPutChar(logger_output_t *output, char character) {
+    if (output->length + 1 < output->size) {
+        output->buffer[output->length] = character;
+    }
+    output->length++;
+}
+
+/**
+ * @brief   Append a text padded to a field width.
+ *
+ * @param[in,out] output   The output state.
+ * @param[in]     text     The text to append.
+ * @param[in]     length   The number of characters of the text.
+ * @param[in]     flags    The flags of the specification, only LOGGER_FLAG_LEFT is used.
+ * @param[in]     width    The minimum field width.
+ */
+static void LoggerPutPadded(logger_output_t *output, const char *text, size_t length, uint8_t flags, size_t width) {
+    size_t padding = (width > length) ? width - length : 0;
+
+    if ((flags & LOGGER_FLAG_LEFT) == 0) {
+        for (; padding > 0; padding--) {
+            LoggerPutChar(output, ' ');
+        }
+    }
+    for (size_t index = 0; index < length; index++) {
+        LoggerPutChar(output, text[index]);
+    }
+    for (; padding > 0; padding--) {
+        LoggerPutChar(output, ' ');
+    }
+}
+
+/**
+ * @brief   Append an integer in the given base.
+ *
+ * @param[in,out] output      The output state.
+ * @param[in]     value       The magnitude of the integer.
+ * @param[in]     negative    true if the integer is negative.
+ * @param[in]     base        The base, 8, 10 or 16.
+ * @param[in]     flags       The flags of the specification.
+ * @param[in]     width       The minimum field width.
+ * @param[in]     precision   The minimum number of digits, or -1 if not given.
+ */
+static void LoggerPutNumber(logger_output_t *output, uint64_t value, bool negative, unsigned int base, uint8_t flags,
+        size_t width, int precision) {
+    const char *digits = (flags & LOGGER_FLAG_UPPER) ? "0123456789ABCDEF" : "0123456789abcdef";
+    char text[24];
+    size_t length = 0;
+    char sign = negative ? '-' : (flags & LOGGER_FLAG_PLUS) ? '+' : (flags & LOGGER_FLAG_SPACE) ? ' ' : '\0';
+
+    // Write the digits backwards, a zero precision prints nothing for a zero value.
+    while (value != 0 || (length == 0 && precision != 0)) {
+        text[length++] = digits[value % base];
+        value /= base;
+    }
+    while ((int) length < precision && length < sizeof(text) - 1) {
+        text[length++] = '0';
+    }
+    // Zero padding goes between the sign and the digits.
+    if ((flags & LOGGER_FLAG_ZERO) && !(flags & LOGGER_FLAG_LEFT) && precision < 0) {
+        while (length + (sign != '\0') < width && length < sizeof(text) - 1) {
+            text[length++] = '0';
+        }
+    }
+    if (sign != '\0') {
+        text[length++] = sign;
+    }
+    // Reverse the digits in place before padding them to the width.
+    for (size_t index = 0; index < length / 2; index++) {
+        char swap = text[index];
+        text[index] = text[length - 1 - index];
+        text[length - 1 - index] = swap;
+    }
+    LoggerPutPadded(output, text, length, flags, width);
+}
+
+/**
+ * @brief   Minimal replacement of vsnprintf used when LOGGER_TINY_PRINTF is defined.
+ *
+ * @details It supports the %d, %i, %u, %x, %X, %o, %s, %c, %p and %% conversions with the '-', '0', '+' and ' '
+ *          flags, the width, the precision, '*' and the hh, h, l, ll, z, j and t length modifiers. %f is supported
+ *          as fixed-point with up to 9 decimals when LOGGER_TINY_PRINTF_FLOAT is defined, with nan and inf like the
+ *          C library and in %e style from 2^64 on. Other conversions are copied as they are.
+ *
+ * @param[out] buffer   The buffer that receives the text.
+ * @param[in]  size     The size of the buffer.
+ * @param[in]  fmt      The format string.
+ * @param[in]  args     The arguments of the format string.
+ *
+ * @return  The number of characters that the full text has, like vsnprintf.
+ */
+static int LoggerVsnprintf(char *buffer, size_t size, const char *fmt, va_list args) {
+    logger_output_t output = {.buffer = buffer, .size = size, .length = 0};
+
+    while (*fmt != '\0') {
+        const char *start = fmt;
+        uint8_t flags = 0;
+        size_t width = 0;
+        int precision = -1;
+        char length_modifier = '\0';
+
+        if (*fmt != '%') {
+            LoggerPutChar(&output, *fmt++);
+            continue;
+        }
+        fmt++;
+        // Read the flags.
+        for (;; fmt++) {
+            if (*fmt == '-') flags |= LOGGER_FLAG_LEFT;
+            else if (*fmt == '0') flags |= LOGGER_FLAG_ZERO;
+            else if (*fmt == '+') flags |= LOGGER_FLAG_PLUS;
+            else if (*fmt == ' ') flags |= LOGGER_FLAG_SPACE;
+            else if (*fmt != '#') break;
+        }
+        // Read the width and the precision.
+        if (*fmt == '*') {
+            int star = va_arg(args, int);
+            if (star < 0) {
+                flags |= LOGGER_FLAG_LEFT;
+                star = -star;
+            }
+            width = (size_t) star;
+            fmt++;
+        }
+        while (*fmt >= '0' && *fmt <= '9') {
+            width = width * 10 + (size_t)(*fmt++ - '0');
+        }
+        if (*fmt == '.') {
+            fmt++;
+            precision = 0;
+            if (*fmt == '*') {
+                precision = va_arg(args, int);
+                fmt++;
+            }
+            while (*fmt >= '0' && *fmt <= '9') {
+                precision = precision * 10 + (*fmt++ - '0');
+            }
+        }
+        // Read the length modifier, "ll" is stored as 'q'.
+        while (*fmt != '\0' && strchr("hljztL", *fmt) != NULL) {
+            length_modifier = (length_modifier == 'l' && *fmt == 'l') ? 'q' : *fmt;
+            fmt++;
+        }
+        switch (*fmt) {
+        case 'd':
+        case 'i': {
+            int64_t value;
+            switch (length_modifier) {
+            case 'l': value = va_arg(args, long); break;
+            case 'q': value = va_arg(args, long long); break;
+            case 'z': value = (int64_t) va_arg(args, size_t); break;
+            case 'j': value = va_arg(args, intmax_t); break;
+            case 't': value = va_arg(args, ptrdiff_t); break;
+            default: value = va_arg(args, int); break;
+            }
+            LoggerPutNumber(&output, (value < 0) ? 0 - (uint64_t) value : (uint64_t) value, value < 0, 10, flags,
+                    width, precision);
+            break;
+        }
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'o': {
+            uint64_t value;
+            switch (length_modifier) {
+            case 'l': value = va_arg(args, unsigned long); break;
+            case 'q': value = va_arg(args, unsigned long long); break;
+            case 'z': value = va_arg(args, size_t); break;
+            case 'j': value = (uint64_t) va_arg(args, intmax_t); break;
+            case 't': value = (uint64_t) va_arg(args, ptrdiff_t); break;
+            default: value = va_arg(args, unsigned int); break;
+            }
+            flags = (uint8_t)(flags & ~(LOGGER_FLAG_PLUS | LOGGER_FLAG_SPACE));
+            LoggerPutNumber(&output, value, false, (*fmt == 'u') ? 10 : (*fmt == 'o') ? 8 : 16,
+                    (*fmt == 'X') ? (flags | LOGGER_FLAG_UPPER) : flags, width, precision);
+            break;
+        }
+        case 'p':
+            LoggerPutChar(&output, '0');
+            LoggerPutChar(&output, 'x');
+            LoggerPutNumber(&output, (uintptr_t) va_arg(args, void *), false, 16, 0, 0, -1);
+            break;
+        case 'c': {
+            char character = (char) va_arg(args, int);
+            LoggerPutPadded(&output, &character, 1, flags, width);
+            break;
+        }
+        case 's': {
+            const char *text = va_arg(args, const char *);
+            size_t length = 0;
+            if (text == NULL) {
+                text = "(null)";
+            }
+            while (text[length] != '\0' && (precision < 0 || length < (size_t) precision)) {
+                length++;
+            }
+            LoggerPutPadded(&output, text, length, flags, width);
+            break;
+        }
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G': {
+            if (length_modifier == 'L') {
+                (void) va_arg(args, long double);
+                LoggerPutPadded(&output, start, (size_t)(fmt + 1 - start), 0, 0);
+                break;
+            }
+            double value = va_arg(args, double);
+#if defined(LOGGER_TINY_PRINTF_FLOAT)
+            if (*fmt == 'f' || *fmt == 'F') {
+                bool upper = (*fmt == 'F');
+                bool negative = signbit(value) != 0;
+                double magnitude = negative ? -value : value;
+                char text[48];
+                logger_output_t fixed = {.buffer = text, .size = sizeof(text), .length = 0};
+                if (isnan(value) || isinf(value)) {
+                    // The conversion to an integer is undefined for these, print them like the C library.
+                    const char *special = isnan(value) ? (upper ? "NAN" : "nan") : (upper ? "INF" : "inf");
+                    char sign = negative ? '-' : (flags & LOGGER_FLAG_PLUS) ? '+' :
+                            (flags & LOGGER_FLAG_SPACE) ? ' ' : '\0';
+                    if (sign != '\0') {
+                        LoggerPutChar(&fixed, sign);
+                    }
+                    while (*special != '\0') {
+                        LoggerPutChar(&fixed, *special++);
+                    }
+                    LoggerPutPadded(&output, text, fixed.length, flags & (uint8_t) ~LOGGER_FLAG_ZERO, width);
+                    break;
+                }
+                // Values beyond the range of uint64_t are printed in %e style, with a decimal exponent.
+                int exponent = -1;
+                if (magnitude >= 18446744073709551616.0) {
+                    for (exponent = 0; magnitude >= 10.0; exponent++) {
+                        magnitude /= 10.0;
+                    }
+                }
+                // Print the value as fixed-point: integer part, then the rounded decimals.
+                uint64_t scale = 1;
+                precision = (precision < 0) ? 6 : (precision > 9) ? 9 : precision;
+                for (int digit = 0; digit < precision; digit++) {
+                    scale *= 10;
+                }
+                uint64_t integer = (uint64_t) magnitude;
+                uint64_t fraction = (uint64_t)((magnitude - (double) integer) * (double) scale + 0.5);
+                if (fraction >= scale) {
+                    integer++;
+                    fraction -= scale;
+                }
+                if (exponent >= 0 && integer >= 10) {
+                    // The rounding carried into a new digit of the mantissa.
+                    integer /= 10;
+                    exponent++;
+                }
+                // Zero padding applies to the integer part, space padding to the whole text.
+                size_t fraction_width = ((precision > 0) ? (size_t) precision + 1 : 0) +
+                        ((exponent >= 0) ? ((exponent >= 100) ? 5 : 4) : 0);
+                bool zero_padded = (flags & LOGGER_FLAG_ZERO) && !(flags & LOGGER_FLAG_LEFT);
+                LoggerPutNumber(&fixed, integer, negative, 10, flags,
+                        (zero_padded && width > fraction_width) ? width - fraction_width : 0, -1);
+                if (precision > 0) {
+                    LoggerPutChar(&fixed, '.');
+                    LoggerPutNumber(&fixed, fraction, false, 10, 0, 0, precision);
+                }
+                if (exponent >= 0) {
+                    LoggerPutChar(&fixed, upper ? 'E' : 'e');
+                    LoggerPutChar(&fixed, '+');
+                    LoggerPutNumber(&fixed, (uint64_t) exponent, false, 10, 0, 0, 2);
+                }
+                LoggerPutPadded(&output, text, (fixed.length < sizeof(text)) ? fixed.length : sizeof(text) - 1,
+                        flags, width);
+                break;
+            }
+#endif
+            (void) value;
+            LoggerPutPadded(&output, start, (size_t)(fmt + 1 - start), 0, 0);
+            break;
+        }
+        case '%':
+            LoggerPutChar(&output, '%');
+            break;
+        default:
+            // Copy unsupported specifications as they are.
+            LoggerPutPadded(&output, start, (size_t)(fmt - start), 0, 0);
+            continue;
+        }
+        fmt++;
+    }
+    // Null-terminate the text, truncating it if needed.
+    if (size > 0) {
+        buffer[(output.length < size) ? output.length : size - 1] = '\0';
+    }
+    return (int) output.length;
+}
+
+/**
+ * @brief   Minimal replacement of snprintf used when LOGGER_TINY_PRINTF is defined.
+ *
+ * @param[out] buffer   The buffer that receives the text.
+ * @param[in]  size     The size of the buffer.
+ * @param[in]  fmt      The format string.
+ * @param[in]  ...      The arguments of the format string.
+ *
+ * @return  The number of characters that the full text has, like snprintf.
+ */
+static int LoggerSnprintf(char *buffer, size_t size, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    int length = LoggerVsnprintf(buffer, size, fmt, args);
+    va_end(args);
+    return length;
+}
+
+/**
+ * @brief Formatter used by the logger.
+ */
+#define LOGGER_SNPRINTF                                                             LoggerSnprintf
+#define LOGGER_VSNPRINTF                                                            LoggerVsnprintf
+
+#else
+
+/**
+ * @brief Formatter used by the logger.
+ */
+#define LOGGER_SNPRINTF                                                             snprintf
+#define LOGGER_VSNPRINTF                                                            vsnprintf
+
+#endif
+
+#if !defined(LOGGER_TOKENIZED)
+
+/**
+ * @brief Size of the text of a timestamp, "18446744073709551.6" at most.
+ */
+#define LOGGER_TIMESTAMP_MAX_LENGTH                                                 24
+
+/**
+ * @brief   Format a timestamp as milliseconds with one decimal using integer arithmetic only.
+ *
+ * @param[out] buffer      The buffer that receives the text, of LOGGER_TIMESTAMP_MAX_LENGTH characters.
+ * @param[in]  timestamp   The elapsed time in microseconds, or LOGGER_TIMESTAMP_INVALID.
+ *
+ * @return  The length of the text.
+ */
+static size_t LoggerFormatTimestamp(char *buffer, uint64_t timestamp) {
+    char digits[LOGGER_TIMESTAMP_MAX_LENGTH];
+    size_t count = 0;
+
+    // Keep the text of the float API when no time source is registered.
+    if (timestamp == LOGGER_TIMESTAMP_INVALID) {
+        strcpy(buffer, "-1.0");
+        return 4;
+    }
+    // Write the digits backwards, starting with the tenths of millisecond.
+    uint64_t tenths = timestamp / 100u;
+    digits[count++] = (char)('0' + tenths % 10u);
+    digits[count++] = '.';
+    tenths /= 10u;
+    do {
+        digits[count++] = (char)('0' + tenths % 10u);
+        tenths /= 10u;
+    } while (tenths != 0);
+    for (size_t index = 0; index < count; index++) {
+        buffer[index] = digits[count - 1 - index];
+    }
+    buffer[count] = '\0';
+    return count;
+}
+
+/**
+ * @brief   Limit the length of a log so that the color reset and the null terminator still fit after it.
+ *
+ * @param[in] length   The length of the log, as returned by snprintf. It may be larger than the buffer.
+ * @param[in] size     The size of the buffer that contains the log.
+ *
+ * @return  The number of characters of the log that are kept in the buffer.
+ */
+static int LoggerClampLength(int length, size_t size) {
+    const int limit = (int)(size - RESET_NEWLINE_LENGTH - 1);
+
+    if (length < 0) {
+        return 0;
+    }
+    return (length < limit) ? length : limit;
+}
+
+/**
+ * @brief   Append text to a log in a log buffer.
+ *
+ * @param[out] buffer        The buffer that contains the log.
+ * @param[in]  size          The size of the buffer.
+ * @param[in]  length        The number of characters already in the buffer, limited by LoggerClampLength().
+ * @param[in]  text          The text to append.
+ * @param[in]  text_length   The length of the text.
+ *
+ * @return  The number of characters of the log in the buffer, limited by LoggerClampLength().
+ */
+static int LoggerAppendText(char *buffer, size_t size, int length, const char *text, size_t text_length) {
+    int end = LoggerClampLength(length + (int) text_length, size);
+
+    memcpy(buffer + length, text, (size_t)(end - length));
+    buffer[end] = '\0';
+    return end;
+}
+
+/**
+ * @brief   Get the length of the color that starts a log of a level in the current output profile.
+ *
+ * @param[in] level   Log level.
+ *
+ * @return  The length of the color, 0 if the profile has no color.
+ */
+static size_t LoggerColorLength(int level) {
+    return (log_profile == LOGGER_PROFILE_FULL) ? strlen(logger_array[level].color) : 0;
+}
+
+/**
+ * @brief   Build the constant parts of the default log syntax of every log level.
+ *
+ * @details The color and the application name come before the timestamp and the level name after it, as far as the
+ *          output profile has them. The prefixes are built when an output is registered, and again by SetAppName()
+ *          and SetLogProfile(). They are read without locking, so these functions belong to the initialization,
+ *          before several contexts log.
+ */
+static void LoggerBuildPrefixes(void) {
+    for (size_t level = 0; level < LOGGER_LEVEL_COUNT; level++) {
+        logger_prefix_t *prefix = &logger_prefixes[level];
+        int length = 0;
+        if (log_profile == LOGGER_PROFILE_COMPACT) {
+            length = LOGGER_SNPRINTF(prefix->prefix, sizeof(prefix->prefix), "[");
+        } else if (log_profile != LOGGER_PROFILE_BARE) {
+            length = LOGGER_SNPRINTF(prefix->prefix, sizeof(prefix->prefix), "%.*s%s[", (int) LoggerColorLength(level),
+                    logger_array[level].color, GetAppName());
+        }
+        prefix->prefix_length = (uint8_t)((length < 0) ? 0 : ((size_t) length < sizeof(prefix->prefix)) ?
+                (size_t) length : sizeof(prefix->prefix) - 1);
+        length = 0;
+        if (log_profile == LOGGER_PROFILE_COMPACT) {
+            length = LOGGER_SNPRINTF(prefix->level, sizeof(prefix->level), "]%c ", logger_array[level].entity.name[0]);
+        } else if (log_profile != LOGGER_PROFILE_BARE) {
+            length = LOGGER_SNPRINTF(prefix->level, sizeof(prefix->level), "] : %s : ",
+                    logger_array[level].entity.name);
+        }
+        prefix->level_length = (uint8_t)((length < 0) ? 0 : ((size_t) length < sizeof(prefix->level)) ?
+                (size_t) length : sizeof(prefix->level) - 1);
+    }
+}
+
+/**
+ * @brief   Get the constant parts of the default log syntax of a log level.
+ *
+ * @param[in] level   Log level.
+ *
+ * @return  The prefix of the log level, built when the outputs were registered.
+ */
+static const logger_prefix_t* LoggerGetPrefix(int level) {
+    return &logger_prefixes[level];
+}
+
+/**
+ * @brief   Write the default log syntax into a log buffer.
+ *
+ * @details This function copies the cached color, application name and level name of a log into the log buffer,
+ *          and formats only the timestamp, file name, function name and line number. Only the parts of the output
+ *          profile are written.
+ *
+ * @param[out] buffer      The buffer that receives the log.
+ * @param[in]  size        The size of the buffer.
+ * @param[in]  level       Log level.
+ * @param[in]  timestamp   The elapsed time in microseconds when the log was produced.
+ * @param[in]  file        The name of the file in which the log is used.
+ * @param[in]  function    The name of the function in which the log is used.
+ * @param[in]  line        The line in which the log is used.
+ *
+ * @return  The number of characters written into the buffer, leaving room for the color reset.
+ */
+static int LoggerFormatHeader(char *buffer, size_t size, int level, uint64_t timestamp, const char *file,
+        const char *function, int line) {
+    const logger_prefix_t *prefix = LoggerGetPrefix(level);
+    char milliseconds[LOGGER_TIMESTAMP_MAX_LENGTH];
+
+    if (log_profile == LOGGER_PROFILE_BARE) {
+        buffer[0] = '\0';
+        return 0;
+    }
+    // Format the timestamp without float printf support.
+    size_t milliseconds_length = LoggerFormatTimestamp(milliseconds, timestamp);
+    // Set the default log syntax.
+    int length = LoggerAppendText(buffer, size, 0, prefix->prefix, prefix->prefix_length);
+    length = LoggerAppendText(buffer, size, length, milliseconds, milliseconds_length);
+    length = LoggerAppendText(buffer, size, length, prefix->level, prefix->level_length);
+    if (log_profile == LOGGER_PROFILE_COMPACT) {
+        return LoggerClampLength(length + LOGGER_SNPRINTF(buffer + length, size - (size_t) length, "%s:%d ", file,
+                line), size);
+    }
+    return LoggerClampLength(length + LOGGER_SNPRINTF(buffer + length, size - (size_t) length, "%s : %s : %d -> ",
+            file, function, line), size);
+}
+
+/**
+ * @brief   Terminate the log in a log buffer.
+ *
+ * @param[out] buffer   The buffer that contains the log.
+ * @param[in]  length   The number of characters of the log in the buffer, limited by LoggerClampLength().
+ *
+ * @return  The number of characters to be printed.
+ */
+static int LoggerTerminateLine(char *buffer, int length) {
+    // Delete the color of the log level for the next log, if the output profile has colors.
+    size_t newline_length = LoggerNewlineLength();
+    memcpy(buffer + length, RESET_NEWLINE, newline_length);
+    buffer[length + (int) newline_length] = '\0';
+    return length + (int) newline_length;
+}
+
+/**
+ * @brief Number of bytes in a row of a hex dump, so that a row fits into the logger buffer.
+ */
+#if LOGGER_BUFFER_MAX_LENGTH >= 128
+#define LOGGER_HEXDUMP_ROW_BYTES                                                    16
+#else
+#define LOGGER_HEXDUMP_ROW_BYTES                                                    8
+#endif
+
+/**
+ * @brief Hexadecimal digits, indexed by nibble.
+ */
+static const char logger_hex_digits[] = "0123456789abcdef";
+
+/**
+ * @brief   Write a row of a hex dump in a log buffer.
+ *
+ * @details The row has the color of the level in the full output profile, the offset, the bytes in hexadecimal and
+ *          in ASCII, and no default log syntax. Every byte is converted by two lookups into a table, without printf.
+ *
+ * @param[out] buffer   The buffer that receives the row, of at least LOGGER_BUFFER_MAX_LENGTH characters.
+ * @param[in]  level    Log level.
+ * @param[in]  offset   The offset of the row in the dump.
+ * @param[in]  data     The bytes of the row.
+ * @param[in]  count    The number of bytes of the row, at most LOGGER_HEXDUMP_ROW_BYTES.
+ *
+ * @return  The number of characters to be printed.
+ */
+static int LoggerFormatHexRow(char *buffer, int level, uint32_t offset, const uint8_t *data, size_t count) {
+    size_t length = LoggerColorLength(level);
+
+    memcpy(buffer, logger_array[level].color, length);
+    for (int shift = 28; shift >= 0; shift -= 4) {
+        buffer[length++] = logger_hex_digits[(offset >> shift) & 0xF];
+    }
+    buffer[length++] = ':';
+    for (size_t index = 0; index < LOGGER_HEXDUMP_ROW_BYTES; index++) {
+        buffer[length++] = ' ';
+        buffer[length++] = (index < count) ? logger_hex_digits[data[index] >> 4] : ' ';
+        buffer[length++] = (index < count) ? logger_hex_digits[data[index] & 0xF] : ' ';
+    }
+    buffer[length++] = ' ';
+    buffer[length++] = '|';
+    for (size_t index = 0; index < count; index++) {
+        buffer[length++] = (data[index] >= 0x20 && data[index] < 0x7F) ? (char) data[index] : '.';
+    }
+    buffer[length++] = '|';
+    return LoggerTerminateLine(buffer, (int) length);
+}
+
+#endif
+
+#if !defined(LOGGER_TOKENIZED)
+
+/**
+ * @brief   Write a log message after the default log syntax in a log buffer.
+ *
+ * @param[out] buffer   The buffer that contains the log.
+ * @param[in]  size     The size of the buffer.
+ * @param[in]  length   The number of characters already in the buffer, limited by LoggerClampLength().
+ * @param[in]  fmt      The string to be printed.
+ * @param[in]  args     The argument to be printed.
+ *
+ * @return  The number of characters of the log in the buffer.
+ */
+static int LoggerFormatMessage(char *buffer, size_t size, int length, const char *fmt, va_list args) {
+    // Write the formatted log message into the space left before the color reset.
+    int written = LOGGER_VSNPRINTF(buffer + length, size - RESET_NEWLINE_LENGTH - length, fmt, args);
+    if (written >= (int)(size - RESET_NEWLINE_LENGTH) - length) {
+        LOGGER_STATS_COUNT(truncated);
+    }
+    // Keep only the characters that were actually stored.
+    return (written > 0) ? LoggerClampLength(length + written, size) : length;
+}
+
+#endif
+
+#if defined(LOGGER_DEFERRED) || defined(LOGGER_TOKENIZED)
+
+#include <stddef.h>
+
+/**
+ * @brief Maximum length of a single conversion specification, such as "%-08.3lx".
+ */
+#define LOGGER_SPEC_MAX_LENGTH                                                      16
+
+/**
+ * @brief Type of the argument consumed by a conversion specification.
+ */
+typedef enum
+{
+    LOGGER_ARG_NONE,                                                                    /**< No argument, e.g. %% */
+    LOGGER_ARG_INT,                                                                     /**< int and promoted types */
+    LOGGER_ARG_LONG,                                                                    /**< long */
+    LOGGER_ARG_LONG_LONG,                                                               /**< long long */
+    LOGGER_ARG_SIZE,                                                                    /**< size_t */
+    LOGGER_ARG_INTMAX,                                                                  /**< intmax_t */
+    LOGGER_ARG_PTRDIFF,                                                                 /**< ptrdiff_t */
+    LOGGER_ARG_POINTER,                                                                 /**< Pointers and strings */
+    LOGGER_ARG_DOUBLE,                                                                  /**< double and promoted float */
+    LOGGER_ARG_LONG_DOUBLE,                                                             /**< long double */
+}logger_arg_type_t;
+
+/**
+ * @brief Precision of a conversion specification without precision, and of one whose precision is an argument.
+ */
+#define LOGGER_PRECISION_NONE                                                       (-1)
+#define LOGGER_PRECISION_ARG                                                        (-2)
+
+/**
+ * @brief Description of a conversion specification in a format string.
+ */
+typedef struct
+{
+    uint8_t length;                                                                     /**< Characters from '%' to the conversion */
+    uint8_t stars;                                                                      /**< Number of '*' width and precision arguments */
+    char conversion;                                                                    /**< Conversion character, e.g. 'd' */
+    int precision;                                                                      /**< Precision, LOGGER_PRECISION_NONE or LOGGER_PRECISION_ARG */
+    logger_arg_type_t type;                                                             /**< Type of the converted argument */
+}logger_spec_t;
+
+/**
+ * @brief Storage for one argument of any supported type.
+ */
+typedef union
+{
+    int i;
+    long l;
+    long long ll;
+    size_t z;
+    intmax_t j;
+    ptrdiff_t t;
+    const void *p;
+    double d;
+    long double ld;
+}logger_arg_t;
+
+/**
+ * @brief   Parse a conversion specification.
+ *
+ * @param[in]  fmt    A pointer to the '%' character that starts the specification.
+ * @param[out] spec   The description of the specification.
+ */
+static void LoggerParseSpec(const char *fmt, logger_spec_t *spec) {
+    const char *p = fmt + 1;
+    int length_modifier = 0;
+
+    spec->stars = 0;
+    spec->conversion = '\0';
+    spec->precision = LOGGER_PRECISION_NONE;
+    spec->type = LOGGER_ARG_NONE;
+    // Skip the flags.
+    while (*p != '\0' && strchr("-+ #0", *p) != NULL) {
+        p++;
+    }
+    // Skip the width and read the precision, counting the ones that are passed as arguments.
+    while (*p != '\0' && (*p == '*' || *p == '.' || (*p >= '0' && *p <= '9'))) {
+        if (*p == '*') {
+            spec->stars++;
+            if (spec->precision != LOGGER_PRECISION_NONE) {
+                spec->precision = LOGGER_PRECISION_ARG;
+            }
+        }
+        else if (*p == '.') {
+            spec->precision = 0;
+        }
+        else if (spec->precision >= 0 && spec->precision < INT16_MAX) {
+            spec->precision = spec->precision * 10 + (*p - '0');
+        }
+        p++;
+    }
+    // Read the length modifier.
+    while (*p != '\0' && strchr("hljztL", *p) != NULL) {
+        length_modifier = (length_modifier == 'l' && *p == 'l') ? 'q' : *p;
+        p++;
+    }
+    // Select the argument type from the conversion.
+    spec->conversion = *p;
+    switch (*p) {
+    case 'd': case 'i': case 'u': case 'o': case 'x': case 'X': case 'c':
+        switch (length_modifier) {
+        case 'l': spec->type = LOGGER_ARG_LONG; break;
+        case 'q': spec->type = LOGGER_ARG_LONG_LONG; break;
+        case 'z': spec->type = LOGGER_ARG_SIZE; break;
+        case 'j': spec->type = LOGGER_ARG_INTMAX; break;
+        case 't': spec->type = LOGGER_ARG_PTRDIFF; break;
+        default: spec->type = LOGGER_ARG_INT; break;
+        }
+        break;
+    case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+        spec->type = (length_modifier == 'L') ? LOGGER_ARG_LONG_DOUBLE : LOGGER_ARG_DOUBLE;
+        break;
+    case 's': case 'p':
+        spec->type = LOGGER_ARG_POINTER;
+        break;
+    default:
+        break;
+    }
+    // Include the conversion character unless the format string ended early.
+    if (*p != '\0') {
+        p++;
+    }
+    spec->length = (uint8_t)((p - fmt) < UINT8_MAX ? (p - fmt) : UINT8_MAX);
+}
+
+/**
+ * @brief   Get the size of an argument of the given type.
+ *
+ * @param[in] type   The type of the argument.
+ *
+ * @return  The size of the argument in bytes.
+ */
+static size_t LoggerArgSize(logger_arg_type_t type) {
+    switch (type) {
+    case LOGGER_ARG_INT:            return sizeof(int);
+    case LOGGER_ARG_LONG:           return sizeof(long);
+    case LOGGER_ARG_LONG_LONG:      return sizeof(long long);
+    case LOGGER_ARG_SIZE:           return sizeof(size_t);
+    case LOGGER_ARG_INTMAX:         return sizeof(intmax_t);
+    case LOGGER_ARG_PTRDIFF:        return sizeof(ptrdiff_t);
+    case LOGGER_ARG_POINTER:        return sizeof(const void *);
+    case LOGGER_ARG_DOUBLE:         return sizeof(double);
+    case LOGGER_ARG_LONG_DOUBLE:    return sizeof(long double);
+    default:                        return 0;
+    }
+}
+
+/**
+ * @brief   Read an argument of the given type from a variable argument list.
+ *
+ * @param[in,out] args    The variable argument list.
+ * @param[in]     type    The type of the argument.
+ * @param[out]    value   The value of the argument.
+ *
+ * @return  The size of the argument in bytes.
+ */
+static size_t LoggerReadArg(va_list *args, logger_arg_type_t type, logger_arg_t *value) {
+    switch (type) {
+    case LOGGER_ARG_INT:            value->i = va_arg(*args, int); break;
+    case LOGGER_ARG_LONG:           value->l = va_arg(*args, long); break;
+    case LOGGER_ARG_LONG_LONG:      value->ll = va_arg(*args, long long); break;
+    case LOGGER_ARG_SIZE:           value->z = va_arg(*args, size_t); break;
+    case LOGGER_ARG_INTMAX:         value->j = va_arg(*args, intmax_t); break;
+    case LOGGER_ARG_PTRDIFF:        value->t = va_arg(*args, ptrdiff_t); break;
+    case LOGGER_ARG_POINTER:        value->p = va_arg(*args, const void *); break;
+    case LOGGER_ARG_DOUBLE:         value->d = va_arg(*args, double); break;
+    case LOGGER_ARG_LONG_DOUBLE:    value->ld = va_arg(*args, long double); break;
+    default:                        break;
+    }
+    return LoggerArgSize(type);
+}
+
+#endif
+
+#if defined(LOGGER_DEFERRED)
+
+/**
+ * @brief Maximum number of 32-bit argument words stored in a deferred log record.
+ */
+#ifndef LOGGER_DEFERRED_MAX_ARG_WORDS
+#define LOGGER_DEFERRED_MAX_ARG_WORDS                                               8
+#endif
+
+/**
+ * @brief A log captured by LOG() and formatted later by LoggerFlush().
+ */
+typedef struct
+{
+    const char *fmt;                                                                    /**< Format string */
+    const char *file;                                                                   /**< File of the call site */
+    const char *function;                                                               /**< Function of the call site */
+    int line;                                                                           /**< Line of the call site */
+    uint64_t timestamp;                                                                 /**< Elapsed microseconds */
+    uint8_t level;                                                                      /**< Log level */
+    uint8_t arg_words;                                                                  /**< Used words of args */
+    uint32_t args[LOGGER_DEFERRED_MAX_ARG_WORDS];                                       /**< Raw argument words */
+}logger_record_t;
+
+/**
+ * @brief Format string of the records that hold a row of a hex dump. Only its address is used.
+ */
+static const char logger_hexdump_row[] = "";
+
+/**
+ * @brief   Number of 32-bit words used to store an argument of the given size.
+ */
+#define LOGGER_ARG_WORDS(size)                                                      (((size) + sizeof(uint32_t) - 1) / sizeof(uint32_t))
+
+/**
+ * @brief   Copy the arguments of a log into raw argument words.
+ *
+ * @details The format string is scanned for conversion specifications and every argument is read with the type
+ *          that the specification expects. Arguments that do not fit into the words are not stored.
+ *
+ * @param[in]  fmt     The format string of the log.
+ * @param[in]  args    The variable arguments of the log.
+ * @param[out] words   The storage for the raw argument words.
+ *
+ * @return  The number of words used.
+ */
+static uint8_t LoggerCaptureArgs(const char *fmt, va_list *args, uint32_t *words) {
+    uint8_t count = 0;
+    logger_spec_t spec;
+    logger_arg_t value;
+
+    for (const char *p = strchr(fmt, '%'); p != NULL; p = strchr(p + spec.length, '%')) {
+        LoggerParseSpec(p, &spec);
+        // The width and the precision are passed as int arguments before the value.
+        for (uint8_t star = 0; star <= spec.stars; star++) {
+            size_t size = LoggerReadArg(args, (star < spec.stars) ? LOGGER_ARG_INT : spec.type, &value);
+            if (count + LOGGER_ARG_WORDS(size) > LOGGER_DEFERRED_MAX_ARG_WORDS) {
+                return count;
+            }
+            memcpy(&words[count], &value, size);
+            count += LOGGER_ARG_WORDS(size);
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief   Format one conversion specification with its width and precision arguments.
+ */
+#define LOGGER_RENDER_ARG(buffer, size, spec, stars, star, member)                                  \
+    ((stars) == 0 ? LOGGER_SNPRINTF(buffer, size, spec, member) :                                   \
+     (stars) == 1 ? LOGGER_SNPRINTF(buffer, size, spec, (star)[0], member) :                        \
+                    LOGGER_SNPRINTF(buffer, size, spec, (star)[0], (star)[1], member))
+
+/**
+ * @brief   Format a log from its format string and raw argument words.
+ *
+ * @details The format string is processed one conversion specification at a time, each of them formatted with the
+ *          argument restored from the words. If the words run out, the rest of the format string is copied as is.
+ *
+ * @param[out] buffer       The buffer that receives the formatted text.
+ * @param[in]  size         The size of the buffer.
+ * @param[in]  fmt          The format string of the log.
+ * @param[in]  words        The raw argument words.
+ * @param[in]  word_count   The number of raw argument words.
+ *
+ * @return  The number of characters written into the buffer, without the null terminator.
+ */
+static size_t LoggerRenderArgs(char *buffer, size_t size, const char *fmt, const uint32_t *words, uint8_t word_count) {
+    size_t length = 0;
+    uint8_t index = 0;
+    bool cut = false;
+    logger_spec_t spec;
+    char spec_text[LOGGER_SPEC_MAX_LENGTH + 1];
+
+    buffer[0] = '\0';
+    while (*fmt != '\0' && length + 1 < size) {
+        const char *percent = strchr(fmt, '%');
+        int written;
+
+        // Copy the text before the next specification.
+        if (percent != fmt) {
+            size_t literal = (percent != NULL) ? (size_t)(percent - fmt) : strlen(fmt);
+            if (literal > size - 1 - length) {
+                literal = size - 1 - length;
+            }
+            memcpy(buffer + length, fmt, literal);
+            length += literal;
+            buffer[length] = '\0';
+            fmt += literal;
+            continue;
+        }
+        LoggerParseSpec(fmt, &spec);
+        size_t value_words = LOGGER_ARG_WORDS(LoggerArgSize(spec.type));
+        size_t star_words = LOGGER_ARG_WORDS(sizeof(int));
+        if (spec.length > LOGGER_SPEC_MAX_LENGTH || spec.stars > 2 ||
+                index + spec.stars * star_words + value_words > word_count) {
+            // Copy the rest of the format string as is if the arguments were not captured.
+            written = LOGGER_SNPRINTF(buffer + length, size - length, "%s", fmt);
+            fmt += strlen(fmt);
+        }
+        else if (spec.type == LOGGER_ARG_NONE) {
+            // Print "%%" as '%' and any unsupported specification as it is.
+            memcpy(spec_text, fmt, spec.length);
+            spec_text[spec.length] = '\0';
+            written = LOGGER_SNPRINTF(buffer + length, size - length, "%s", (strcmp(spec_text, "%%") == 0) ? "%" : spec_text);
+            fmt += spec.length;
+        }
+        else {
+            int star[2] = {0, 0};
+            logger_arg_t value;
+            // Restore the width and the precision, then the value itself.
+            for (uint8_t s = 0; s < spec.stars; s++) {
+                memcpy(&star[s], &words[index], sizeof(int));
+                index += star_words;
+            }
+            memset(&value, 0x00, sizeof(value));
+            memcpy(&value, &words[index], value_words * sizeof(uint32_t));
+            index += value_words;
+            memcpy(spec_text, fmt, spec.length);
+            spec_text[spec.length] = '\0';
+            switch (spec.type) {
+            case LOGGER_ARG_INT:            written = LOGGER_RENDER_ARG(buffer + length, size - length, spec_text, spec.stars, star, value.i); break;
+            case LOGGER_ARG_LONG:           written = LOGGER_RENDER_ARG(buffer + length, size - length, spec_text, spec.stars, star, value.l); break;
+            case LOGGER_ARG_LONG_LONG:      written = LOGGER_RENDER_ARG(buffer + length, size - length, spec_text, spec.stars, star, value.ll); break;
+            case LOGGER_ARG_SIZE:           written = LOGGER_RENDER_ARG(buffer + length, size - length, spec_text, spec.stars, star, value.z); break;
+            case LOGGER_ARG_INTMAX:         written = LOGGER_RENDER_ARG(buffer + length, size - length, spec_text, spec.stars, star, value.j); break;
+            case LOGGER_ARG_PTRDIFF:        written = LOGGER_RENDER_ARG(buffer + length, size - length, spec_text, spec.stars, star, value.t); break;
+            case LOGGER_ARG_POINTER:        written = LOGGER_RENDER_ARG(buffer + length, size - length, spec_text, spec.stars, star, value.p); break;
+            case LOGGER_ARG_DOUBLE:         written = LOGGER_RENDER_ARG(buffer + length, size - length, spec_text, spec.stars, star, value.d); break;
+            case LOGGER_ARG_LONG_DOUBLE:    written = LOGGER_RENDER_ARG(buffer + length, size - length, spec_text, spec.stars, star, value.ld); break;
+            default:                        written = 0; break;
+            }
+            fmt += spec.length;
+        }
+        // Stop at the end of the buffer.
+        if (written < 0) {
+            break;
+        }
+        cut = ((size_t) written >= size - length);
+        length = cut ? size - 1 : length + written;
+    }
+    if (cut || *fmt != '\0') {
+        LOGGER_STATS_COUNT(truncated);
+    }
+    return length;
+}
+
+#endif
+
+#if defined(LOGGER_TOKENIZED)
+
+/**
+ * @brief First byte of every tokenized frame.
+ */
+#define LOGGER_TOKEN_SYNC                                                           0xA5
+
+/**
+ * @brief Size of the frame header: sync, length, token, timestamp and level.
+ */
+#define LOGGER_TOKEN_HEADER_LENGTH                                                  11
+
+/**
+ * @brief Maximum size of a tokenized frame, limited by its one-byte length field.
+ */
+#define LOGGER_TOKEN_FRAME_MAX_LENGTH                                               (LOGGER_BUFFER_MAX_LENGTH < 257 ? LOGGER_BUFFER_MAX_LENGTH : 257)
+
+/**
+ * @brief Reserved token of the frame that reports dropped logs. Its only argument is the number of dropped logs.
+ */
+#define LOGGER_TOKEN_DROPPED                                                        0
+
+/**
+ * @brief   Calculate the token of a call site.
+ *
+ * @details The token is the 32-bit FNV-1a hash of the file name followed by the line number as four
+ *          little-endian bytes. The host-side decoder (tools/logger_decode.py) calculates the same hash from the
+ *          sources to find the format string of a frame. Zero is reserved, so it is replaced by one.
+ *
+ * @param[in] file   The name of the file in which the log is used.
+ * @param[in] line   The line in which the log is used.
+ *
+ * @return  The token of the call site.
+ */
+static uint32_t LoggerTokenize(const char *file, int line) {
+    uint32_t hash = 0x811C9DC5u;
+
+    for (const char *p = GetFileNameFromPath(file); *p != '\0'; p++) {
+        hash = (hash ^ (uint8_t) *p) * 0x01000193u;
+    }
+    for (int shift = 0; shift < 32; shift += 8) {
+        hash = (hash ^ (uint8_t)((uint32_t) line >> shift)) * 0x01000193u;
+    }
+    return (hash != LOGGER_TOKEN_DROPPED) ? hash : 1;
+}
+
+/**
+ * @brief   Write a 32-bit value as four little-endian bytes.
+ *
+ * @param[out] buffer   The destination of the value.
+ * @param[in]  value    The value to write.
+ */
+static void LoggerPutWord(uint8_t *buffer, uint32_t value) {
+    buffer[0] = (uint8_t) value;
+    buffer[1] = (uint8_t)(value >> 8);
+    buffer[2] = (uint8_t)(value >> 16);
+    buffer[3] = (uint8_t)(value >> 24);
+}
+
+/**
+ * @brief   Write an unsigned value as a base-128 varint.
+ *
+ * @param[out] buffer   The destination of the value.
+ * @param[in]  size     The space available in the destination.
+ * @param[in]  value    The value to write.
+ *
+ * @return  The number of bytes written, or 0 if the value does not fit.
+ */
+static size_t LoggerPutVarint(uint8_t *buffer, size_t size, uint64_t value) {
+    size_t length = 0;
+
+    do {
+        if (length >= size) {
+            return 0;
+        }
+        buffer[length++] = (uint8_t)((value & 0x7F) | (value > 0x7F ? 0x80 : 0x00));
+        value >>= 7;
+    } while (value != 0);
+    return length;
+}
+
+/**
+ * @brief   Write the header of a tokenized frame.
+ *
+ * @details The frame starts with the sync byte and the number of bytes that follow the length byte, then the
+ *          token and the timestamp in milliseconds as little-endian 32-bit words, then the log level.
+ *
+ * @param[out] buffer   The buffer that receives the frame.
+ * @param[in]  level    Log level.
+ * @param[in]  token    The token of the call site.
+ *
+ * @return  The number of bytes written.
+ */
+static size_t LoggerTokenHeader(uint8_t *buffer, int level, uint32_t token) {
+    uint64_t timestamp = GetMicroseconds();
+
+    buffer[0] = LOGGER_TOKEN_SYNC;
+    buffer[1] = 0;
+    LoggerPutWord(buffer + 2, token);
+    LoggerPutWord(buffer + 6, (timestamp != LOGGER_TIMESTAMP_INVALID) ? (uint32_t)(timestamp / 1000u) : 0);
+    buffer[10] = (uint8_t) level;
+    return LOGGER_TOKEN_HEADER_LENGTH;
+}
+
+/**
+ * @brief   Pack the arguments of a log into a tokenized frame.
+ *
+ * @details Integers are written as varints, zigzag encoded for the signed conversions, floating-point values as
+ *          little-endian 32-bit floats and strings as a varint length followed by the characters. Packing stops
+ *          at the first argument that does not fit.
+ *
+ * @param[out] buffer   The buffer that receives the arguments.
+ * @param[in]  size     The space available in the buffer.
+ * @param[in]  fmt      The format string of the log.
+ * @param[in]  args     The variable arguments of the log.
+ *
+ * @return  The number of bytes written.
+ */
+static size_t LoggerPackArgs(uint8_t *buffer, size_t size, const char *fmt, va_list *args) {
+    size_t length = 0;
+    logger_spec_t spec;
+    logger_arg_t value;
+
+    for (const char *p = strchr(fmt, '%'); p != NULL; p = strchr(p + spec.length, '%')) {
+        LoggerParseSpec(p, &spec);
+        int precision = spec.precision;
+        for (uint8_t star = 0; star <= spec.stars; star++) {
+            logger_arg_type_t type = (star < spec.stars) ? LOGGER_ARG_INT : spec.type;
+            bool is_signed = (star < spec.stars) || spec.conversion == 'd' || spec.conversion == 'i';
+            int64_t integer = 0;
+            size_t written = 0;
+
+            LoggerReadArg(args, type, &value);
+            if (star + 1 == spec.stars && spec.precision == LOGGER_PRECISION_ARG) {
+                // A negative precision argument is taken as if the precision were omitted.
+                precision = (value.i >= 0) ? value.i : LOGGER_PRECISION_NONE;
+            }
+            switch (type) {
+            case LOGGER_ARG_NONE:           continue;
+            case LOGGER_ARG_INT:            integer = is_signed ? (int64_t) value.i : (int64_t)(unsigned int) value.i; break;
+            case LOGGER_ARG_LONG:           integer = is_signed ? (int64_t) value.l : (int64_t)(unsigned long) value.l; break;
+            case LOGGER_ARG_LONG_LONG:      integer = value.ll; break;
+            case LOGGER_ARG_SIZE:           integer = (int64_t) value.z; break;
+            case LOGGER_ARG_INTMAX:         integer = value.j; break;
+            case LOGGER_ARG_PTRDIFF:        integer = value.t; break;
+            case LOGGER_ARG_POINTER:        integer = (int64_t)(uintptr_t) value.p; break;
+            case LOGGER_ARG_DOUBLE:
+            case LOGGER_ARG_LONG_DOUBLE: {
+                float real = (type == LOGGER_ARG_DOUBLE) ? (float) value.d : (float) value.ld;
+                uint32_t bits;
+                memcpy(&bits, &real, sizeof(bits));
+                if (size - length < sizeof(bits)) {
+                    return length;
+                }
+                LoggerPutWord(buffer + length, bits);
+                length += sizeof(bits);
+                continue;
+            }
+            }
+            if (star == spec.stars && spec.conversion == 's') {
+                // Strings are sent inline, the host cannot read the device memory. Only the characters that the
+                // precision lets through and that fit into the frame are read.
+                const char *text = (value.p != NULL) ? (const char *) value.p : "(null)";
+                size_t room = size - length;
+                size_t bound = (precision >= 0 && (size_t) precision < room) ? (size_t) precision : room;
+                const char *end = memchr(text, '\0', bound);
+                size_t text_length = (end != NULL) ? (size_t)(end - text) : bound;
+                written = LoggerPutVarint(buffer + length, room, text_length);
+                if (written == 0) {
+                    return length;
+                }
+                if (text_length > room - written) {
+                    // Cut the string to the space left after its length, which does not grow by getting shorter.
+                    text_length = room - written;
+                    written = LoggerPutVarint(buffer + length, room, text_length);
+                }
+                memcpy(buffer + length + written, text, text_length);
+                written += text_length;
+            }
+            else if (is_signed) {
+                written = LoggerPutVarint(buffer + length, size - length,
+                        ((uint64_t) integer << 1) ^ (uint64_t)(integer >> 63));
+            }
+            else {
+                written = LoggerPutVarint(buffer + length, size - length, (uint64_t) integer);
+            }
+            if (written == 0) {
+                return length;
+            }
+            length += written;
+        }
+    }
+    return length;
+}
+
+/**
+ * @brief   Write a complete tokenized frame of a log into a buffer.
+ *
+ * @param[out] buffer   The buffer that receives the frame.
+ * @param[in]  level    Log level.
+ * @param[in]  token    The token of the call site.
+ * @param[in]  fmt      The format string of the log.
+ * @param[in]  args     The variable arguments of the log.
+ *
+ * @return  The number of bytes of the frame.
+ */
+static size_t LoggerTokenFrame(uint8_t *buffer, int level, uint32_t token, const char *fmt, va_list *args) {
+    size_t length = LoggerTokenHeader(buffer, level, token);
+    length += LoggerPackArgs(buffer + length, LOGGER_TOKEN_FRAME_MAX_LENGTH - length, fmt, args);
+    buffer[1] = (uint8_t)(length - 2);
+    return length;
+}
+
+#endif
+
+#if defined(LOGGER_RING)
+
+#include <stdatomic.h>
+
+/**
+ * @brief Number of slots in the log ring. It must be a power of two of at least 2, so that the committed sequence of
+ *        a slot differs from its free sequence of the next lap.
+ */
+#ifndef LOGGER_RING_LENGTH
+#define LOGGER_RING_LENGTH                                                          8
+#endif
+
+#if (LOGGER_RING_LENGTH & (LOGGER_RING_LENGTH - 1)) != 0
+#error "LOGGER_RING_LENGTH must be a power of two"
+#endif
+
+#if LOGGER_RING_LENGTH < 2
+#error "LOGGER_RING_LENGTH must be at least 2"
+#endif
+
+/**
+ * @brief A fixed-size slot of the log ring.
+ *
+ * @details The sequence tells the owner of the slot. It holds the first position of the current lap of the ring
+ *          when the slot is free, and that position plus one once a producer has committed a log into it.
+ */
+typedef struct
+{
+    atomic_uint_least32_t sequence;                                                      /**< Free or committed state */
+#if defined(LOGGER_DEFERRED)
+    logger_record_t record;                                                             /**< Deferred log record */
+#else
+    int level;                                                                          /**< Log level */
+    int length;                                                                         /**< Length of the log */
+    char text[LOGGER_BUFFER_MAX_LENGTH];                                                /**< Formatted log */
+#endif
+}logger_slot_t;
+
+/**
+ * @brief Lock-free multi-producer, single-consumer ring of log slots.
+ */
+static logger_slot_t logger_ring[LOGGER_RING_LENGTH];
+
+/**
+ * @brief Position of the next slot to be reserved by a producer.
+ */
+static atomic_uint_least32_t logger_ring_reserve = 0;
+
+/**
+ * @brief Position of the next slot to be printed by the consumer.
+ */
+static uint_least32_t logger_ring_consume = 0;
+
+/**
+ * @brief Number of logs dropped because the ring was full, reported by the next LoggerFlush().
+ */
+static atomic_uint_least32_t logger_dropped_logs = 0;
+
+/**
+ * @brief   Reserve a free slot in the log ring.
+ *
+ * @details The slot is owned by the caller until it is passed to LoggerRingCommit(). Several producers may
+ *          reserve slots at the same time, including from interrupts, without any lock.
+ *
+ * @return  A pointer to the reserved slot, or NULL if the ring is full.
+ */
+static logger_slot_t* LoggerRingReserve(void) {
+    uint_least32_t position = atomic_load_explicit(&logger_ring_reserve, memory_order_relaxed);
+
+    for (;;) {
+        logger_slot_t *slot = &logger_ring[position & (LOGGER_RING_LENGTH - 1)];
+        uint_least32_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        int32_t difference = (int32_t)(sequence - (position & ~(uint_least32_t)(LOGGER_RING_LENGTH - 1)));
+
+        if (difference == 0) {
+            // The slot is free for this lap, try to take it.
+            if (atomic_compare_exchange_weak_explicit(&logger_ring_reserve, &position, position + 1,
+                    memory_order_relaxed, memory_order_relaxed)) {
+                return slot;
+            }
+        }
+        else if (difference < 0) {
+            // The slot still holds a log of the previous lap, so the ring is full.
+            atomic_fetch_add_explicit(&logger_dropped_logs, 1, memory_order_relaxed);
+            LOGGER_STATS_COUNT(dropped);
+            return NULL;
+        }
+        else {
+            // Another producer took the slot, try the next position.
+            position = atomic_load_explicit(&logger_ring_reserve, memory_order_relaxed);
+        }
+    }
+}
+
+/**
+ * @brief   Publish a reserved slot to the consumer.
+ *
+ * @param[in] slot   The slot returned by LoggerRingReserve().
+ */
+static void LoggerRingCommit(logger_slot_t *slot) {
+    uint_least32_t sequence = atomic_load_explicit(&slot->sequence, memory_order_relaxed);
+    atomic_store_explicit(&slot->sequence, sequence + 1, memory_order_release);
+}
+
+#endif
+
+#if defined(LOGGER_ASYNC)
+
+#include <stdatomic.h>
+
+/**
+ * @brief Number of buffers used for asynchronous output.
+ */
+#ifndef LOGGER_ASYNC_BUFFER_COUNT
+#define LOGGER_ASYNC_BUFFER_COUNT                                                   2
+#endif
+
+/**
+ * @brief Size of each asynchronous output buffer, at least one log of LOGGER_BUFFER_MAX_LENGTH bytes.
+ *
+ * @details The buffers go out through LoggerWrite(), whole to a function registered with
+ *          LoggerRegisterWriteFunction(). Without one, a buffer is closed at 255 bytes, so that it goes out in a
+ *          single call of the LoggerPrintf function, see LoggerAsyncCapacity().
+ */
+#ifndef LOGGER_ASYNC_BUFFER_SIZE
+#define LOGGER_ASYNC_BUFFER_SIZE                                                    LOGGER_BUFFER_MAX_LENGTH
+#endif
+
+#if LOGGER_ASYNC_BUFFER_COUNT < 2
+#error "LOGGER_ASYNC_BUFFER_COUNT must be at least 2"
+#endif
+
+#if LOGGER_ASYNC_BUFFER_SIZE < LOGGER_BUFFER_MAX_LENGTH
+#error "LOGGER_ASYNC_BUFFER_SIZE must be at least LOGGER_BUFFER_MAX_LENGTH"
+#endif
+
+/**
+ * @brief Buffers of the asynchronous output, used one after the other.
+ */
+static uint8_t logger_async_buffers[LOGGER_ASYNC_BUFFER_COUNT][LOGGER_ASYNC_BUFFER_SIZE];
+
+/**
+ * @brief Number of bytes of each asynchronous output buffer.
+ */
+static size_t logger_async_lengths[LOGGER_ASYNC_BUFFER_COUNT];
+
+/**
+ * @brief Number of buffers closed since start-up. The buffer after the last closed one is being filled.
+ */
+static atomic_uint_least32_t logger_async_head = 0;
+
+/**
+ * @brief Number of buffers transmitted since start-up. The buffer after the last transmitted one is being sent
+ *        while a transmission is in progress.
+ */
+static atomic_uint_least32_t logger_async_tail = 0;
+
+/**
+ * @brief Whether a transmission is in progress.
+ */
+static atomic_bool logger_async_busy = false;
+
+/**
+ * @brief Whether LOG() is writing into the buffer being filled, so that LoggerTxComplete() must not close it.
+ */
+static atomic_bool logger_async_writing = false;
+
+/**
+ * @brief Number of logs dropped because every buffer was full, reported by the next LoggerFlush().
+ */
+static atomic_uint_least32_t logger_async_dropped = 0;
+
+/**
+ * @brief   Get the number of bytes that a buffer is filled with before it is closed.
+ *
+ * @details Every call of the LoggerPrintf function starts a transmission that ends with one LoggerTxComplete(), so
+ *          without a write function a buffer must not hold more than the 255 bytes of a single call.
+ *
+ * @return  The capacity of a buffer.
+ */
+static size_t LoggerAsyncCapacity(void) {
+    return (pfLoggerWrite != NULL || LOGGER_ASYNC_BUFFER_SIZE < UINT8_MAX) ? LOGGER_ASYNC_BUFFER_SIZE : UINT8_MAX;
+}
+
+/**
+ * @brief   Close the buffer being filled and start filling the next one.
+ *
+ * @return  false if no buffer is free, true otherwise.
+ */
+static bool LoggerAsyncClose(void) {
+    uint_least32_t head = atomic_load(&logger_async_head);
+
+    if (head + 1 - atomic_load(&logger_async_tail) >= LOGGER_ASYNC_BUFFER_COUNT) {
+        return false;
+    }
+    logger_async_lengths[(head + 1) % LOGGER_ASYNC_BUFFER_COUNT] = 0;
+    atomic_store(&logger_async_head, head + 1);
+    return true;
+}
+
+/**
+ * @brief   Transmit the next closed buffer, or mark the output idle if there is none.
+ *
+ * @details The caller must own the transmission, i.e. have set logger_async_busy.
+ */
+static void LoggerAsyncStart(void) {
+    for (;;) {
+        uint_least32_t tail = atomic_load(&logger_async_tail);
+        if (tail != atomic_load(&logger_async_head)) {
+            uint32_t index = tail % LOGGER_ASYNC_BUFFER_COUNT;
+            LoggerWrite(logger_async_buffers[index], logger_async_lengths[index]);
+            return;
+        }
+        atomic_store(&logger_async_busy, false);
+        // Check again in case a buffer was closed before the output became idle.
+        bool idle = false;
+        if (tail == atomic_load(&logger_async_head) || !atomic_compare_exchange_strong(&logger_async_busy, &idle, true)) {
+            return;
+        }
+    }
+}
+
+/**
+ * @brief   Hand the buffer being filled to the output if it is idle.
+ */
+static void LoggerAsyncKick(void) {
+    bool idle = false;
+
+    if (atomic_compare_exchange_strong(&logger_async_busy, &idle, true)) {
+        if (logger_async_lengths[atomic_load(&logger_async_head) % LOGGER_ASYNC_BUFFER_COUNT] > 0) {
+            LoggerAsyncClose();
+        }
+        LoggerAsyncStart();
+    }
+}
+
+/**
+ * @brief   Append a complete log to the asynchronous output.
+ *
+ * @details The log is copied into the buffer being filled, which is closed and replaced by the next one when it
+ *          is full. The log is dropped if every other buffer is still waiting to be transmitted, or if it is longer
+ *          than a buffer.
+ *
+ * @param[in] p     A pointer to the log.
+ * @param[in] len   The length of the log.
+ */
+static void LoggerAsyncWrite(const uint8_t *p, size_t len) {
+    size_t capacity = LoggerAsyncCapacity();
+
+    atomic_store(&logger_async_writing, true);
+    uint32_t index = atomic_load(&logger_async_head) % LOGGER_ASYNC_BUFFER_COUNT;
+    if (logger_async_lengths[index] + len > capacity) {
+        if (len > capacity || !LoggerAsyncClose()) {
+            atomic_store(&logger_async_writing, false);
+            atomic_fetch_add(&logger_async_dropped, 1);
+            LOGGER_STATS_COUNT(dropped);
+            return;
+        }
+        index = atomic_load(&logger_async_head) % LOGGER_ASYNC_BUFFER_COUNT;
+    }
+    memcpy(logger_async_buffers[index] + logger_async_lengths[index], p, len);
+    logger_async_lengths[index] += len;
+    atomic_store(&logger_async_writing, false);
+    LoggerAsyncKick();
+}
+
+/**
+ * @brief   Signal the end of an asynchronous transmission.
+ *
+ * @details This function must be called, typically from the DMA or UART interrupt, when the buffer passed to the
+ *          LoggerPrintf function has been transmitted. It frees that buffer and starts the transmission of the
+ *          next one. The buffer being filled is also sent if LOG() is not writing into it. A call without a
+ *          transmission in progress is ignored.
+ */
+void LoggerTxComplete(void) {
+    uint_least32_t tail = atomic_load(&logger_async_tail);
+
+    // Never free a buffer that was not sent, which would move the tail past the head.
+    if (!atomic_load(&logger_async_busy) || tail == atomic_load(&logger_async_head)) {
+        return;
+    }
+    atomic_store(&logger_async_tail, tail + 1);
+    if (!atomic_load(&logger_async_writing) &&
+            logger_async_lengths[atomic_load(&logger_async_head) % LOGGER_ASYNC_BUFFER_COUNT] > 0) {
+        LoggerAsyncClose();
+    }
+    LoggerAsyncStart();
+}
+
+#endif
+
+#if defined(LOGGER_BATCH)
+
+/**
+ * @brief Size of the batch buffer.
+ */
+#ifndef LOGGER_BATCH_SIZE
+#define LOGGER_BATCH_SIZE                                                           512
+#endif
+
+/**
+ * @brief Age in milliseconds of the first log of the batch after which the batch is printed.
+ */
+#ifndef LOGGER_BATCH_TIMEOUT_MS
+#define LOGGER_BATCH_TIMEOUT_MS                                                     100
+#endif
+
+/**
+ * @brief Logs waiting to be printed in one call.
+ */
+static uint8_t logger_batch[LOGGER_BATCH_SIZE];
+
+/**
+ * @brief Number of bytes of the batch.
+ */
+static size_t logger_batch_length = 0;
+
+/**
+ * @brief Timestamp of the first log of the batch, in microseconds.
+ */
+static uint64_t logger_batch_start = 0;
+
+/**
+ * @brief   Print the batch and empty it.
+ *
+ * @details The caller must hold the output lock in thread-safe mode.
+ */
+static void LoggerBatchFlush(void) {
+    if (logger_batch_length > 0) {
+        LoggerWrite(logger_batch, logger_batch_length);
+        logger_batch_length = 0;
+    }
+}
+
+/**
+ * @brief   Add a complete log to the batch.
+ *
+ * @details The batch is printed first if the log does not fit, and logs larger than the batch are printed on their
+ *          own. The batch is printed at once after an error, or when its first log is older than
+ *          LOGGER_BATCH_TIMEOUT_MS.
+ *
+ * @param[in] level   Log level.
+ * @param[in] p       A pointer to the log.
+ * @param[in] len     The length of the log.
+ */
+static void LoggerBatchWrite(int level, const uint8_t *p, size_t len) {
+    uint64_t now = GetMicroseconds();
+
+    if (logger_batch_length + len > LOGGER_BATCH_SIZE) {
+        LoggerBatchFlush();
+    }
+    if (len > LOGGER_BATCH_SIZE) {
+        LoggerWrite(p, len);
+        return;
+    }
+    if (logger_batch_length == 0) {
+        logger_batch_start = now;
+    }
+    memcpy(logger_batch + logger_batch_length, p, len);
+    logger_batch_length += len;
+    if (level >= (int) ERR || (now != LOGGER_TIMESTAMP_INVALID && logger_batch_start != LOGGER_TIMESTAMP_INVALID &&
+            now - logger_batch_start >= (uint64_t) LOGGER_BATCH_TIMEOUT_MS * 1000u)) {
+        LoggerBatchFlush();
+    }
+}
+
+/**
+ * @brief   Print the batch from LoggerFlush().
+ */
+static void LoggerBatchSync(void) {
+#if defined(LOGGER_THREAD_SAFE)
+    if (pfLoggerLock != NULL) {
+        pfLoggerLock();
+    }
+#endif
+    LoggerBatchFlush();
+#if defined(LOGGER_THREAD_SAFE)
+    if (pfLoggerUnlock != NULL) {
+        pfLoggerUnlock();
+    }
+#endif
+}
+
+#endif
+
+#if !defined(LOGGER_TOKENIZED)
+
+/**
+ * @brief   Check if a log starts with the color of its level and ends with the color reset.
+ *
+ * @param[in] level   Log level.
+ * @param[in] p       A pointer to the log.
+ * @param[in] len     The length of the log.
+ *
+ * @return  true if the color and the color reset can be cut off the log, false otherwise.
+ */
+static bool LoggerIsColored(int level, const uint8_t *p, size_t len) {
+    size_t color_length = strlen(logger_array[level].color);
+    const char *reset = RESET_NEWLINE + RESET_NEWLINE_LENGTH - LOGGER_COLOR_RESET_LENGTH;
+
+    return len >= color_length + LOGGER_COLOR_RESET_LENGTH && memcmp(p, logger_array[level].color, color_length) == 0 &&
+            memcmp(p + len - LOGGER_COLOR_RESET_LENGTH, reset, LOGGER_COLOR_RESET_LENGTH) == 0;
+}
+
+#endif
+
+/**
+ * @brief   Send a complete log to the output.
+ *
+ * @details In asynchronous mode (LOGGER_ASYNC) the log is queued into the output buffers, otherwise it is printed
+ *          immediately through the LoggerPrintf function. The log is then passed to every sink that wants its
+ *          level, without its color codes for the sinks that do not want them.
+ *
+ * @param[in] level   Log level.
+ * @param[in] p       A pointer to the log.
+ * @param[in] len     The length of the log.
+ */
+static void LoggerOutput(int level, const uint8_t *p, size_t len) {
+#if defined(LOGGER_THREAD_SAFE)
+    // Only the handoff to the output is serialized, the log has been formatted already.
+    if (pfLoggerLock != NULL) {
+        pfLoggerLock();
+    }
+#endif
+#if defined(LOGGER_STATS)
+    logger_stats.emitted[level]++;
+    logger_stats.bytes += len;
+#endif
+    uint64_t start = LoggerStatsTicks();
+#if defined(LOGGER_ASYNC)
+    LoggerAsyncWrite(p, len);
+#elif defined(LOGGER_BATCH)
+    LoggerBatchWrite(level, p, len);
+#else
+    LoggerWrite(p, len);
+#endif
+    LoggerStatsOutput(start);
+    for (size_t index = 0; logger_sink_count != 0 && index < LOGGER_SINK_COUNT; index++) {
+        const logger_sink_t *sink = &logger_sinks[index];
+        if (sink->print == NULL || level < (int) sink->level) {
+            continue;
+        }
+        const uint8_t *text = p;
+        size_t text_length = len;
+#if !defined(LOGGER_TOKENIZED)
+        // The color comes first and the color reset last, so they can be cut off without copying the log. The log
+        // may have been formatted in another output profile than the current one, so the text itself is checked.
+        if (!sink->color && LoggerIsColored(level, p, len)) {
+            text = p + strlen(logger_array[level].color);
+            text_length = len - strlen(logger_array[level].color) - LOGGER_COLOR_RESET_LENGTH;
+        }
+#endif
+        start = LoggerStatsTicks();
+        LoggerPrintChunks(sink->print, text, text_length);
+        LoggerStatsOutput(start);
+    }
+#if defined(LOGGER_THREAD_SAFE)
+    if (pfLoggerUnlock != NULL) {
+        pfLoggerUnlock();
+    }
+#endif
+}
+
+#if defined(LOGGER_RING) || defined(LOGGER_ASYNC) || defined(LOGGER_ISR_ENABLED)
+
+/**
+ * @brief   Print a log that reports how many logs were dropped.
+ *
+ * @param[in] dropped   The number of dropped logs, nothing is printed if it is zero.
+ */
+static void LoggerReportDropped(uint32_t dropped) {
+#if defined(LOGGER_ASYNC)
+    dropped += atomic_exchange(&logger_async_dropped, 0);
+#endif
+    if (dropped == 0) {
+        return;
+    }
+#if defined(LOGGER_TOKENIZED)
+    uint8_t *buffer = (uint8_t *) LoggerBuffer();
+    size_t length = LoggerTokenHeader(buffer, WARN, LOGGER_TOKEN_DROPPED);
+    length += LoggerPutVarint(buffer + length, LOGGER_TOKEN_FRAME_MAX_LENGTH - length, dropped);
+    buffer[1] = (uint8_t)(length - 2);
+    LoggerOutput(WARN, buffer, length);
+#else
+    LOGGER_FILE_NAME(file_name);
+    char *buffer = LoggerBuffer();
+    int length = LoggerFormatHeader(buffer, LOGGER_BUFFER_MAX_LENGTH, WARN, GetMicroseconds(),
+            file_name, __FUNCTION__, __LINE__);
+    length = LoggerClampLength(length + LOGGER_SNPRINTF(buffer + length,
+            LOGGER_BUFFER_MAX_LENGTH - RESET_NEWLINE_LENGTH - length, "%lu logs dropped", (unsigned long) dropped),
+            LOGGER_BUFFER_MAX_LENGTH);
+    length = LoggerTerminateLine(buffer, length);
+    LoggerOutput(WARN, (uint8_t *) buffer, length);
+#endif
+}
+
+#endif
+
+#if defined(LOGGER_DEFERRED)
+
+/**
+ * @brief   Format a deferred record into a log buffer.
+ *
+ * @param[out] buffer   The buffer that receives the log, of LOGGER_BUFFER_MAX_LENGTH characters.
+ * @param[in]  record   The record.
+ *
+ * @return  The number of characters to be printed.
+ */
+static int LoggerFormatRecord(char *buffer, const logger_record_t *record) {
+    if (record->fmt == logger_hexdump_row) {
+        // A row of a hex dump, see LOG_HEXDUMP().
+        return LoggerFormatHexRow(buffer, record->level, (uint32_t) record->line, (const uint8_t *) record->args,
+                record->arg_words);
+    }
+    int length = LoggerFormatHeader(buffer, LOGGER_BUFFER_MAX_LENGTH, record->level, record->timestamp,
+            record->file, record->function, record->line);
+    // Write the log message into the space left before the color reset.
+    length += (int) LoggerRenderArgs(buffer + length, LOGGER_BUFFER_MAX_LENGTH - RESET_NEWLINE_LENGTH - length,
+            record->fmt, record->args, record->arg_words);
+    return LoggerTerminateLine(buffer, length);
+}
+
+#endif
+
+#if defined(LOGGER_RING)
+
+/**
+ * @brief   Print the committed slots of the log ring in order and free them for the producers.
+ *
+ * @details It stops at the first slot that is not committed yet. In deferred mode the records are formatted here.
+ *
+ * @param[in] panic   true to write the logs to the panic function, false to send them to the outputs.
+ */
+static void LoggerRingDrain(bool panic) {
+    for (;;) {
+        logger_slot_t *slot = &logger_ring[logger_ring_consume & (LOGGER_RING_LENGTH - 1)];
+        uint_least32_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        uint_least32_t lap = logger_ring_consume & ~(uint_least32_t)(LOGGER_RING_LENGTH - 1);
+
+        // Stop at the first slot that has not been committed.
+        if (sequence != lap + 1) {
+            break;
+        }
+#if defined(LOGGER_DEFERRED)
+        char *text = LoggerBuffer();
+        int level = slot->record.level;
+        int length = LoggerFormatRecord(text, &slot->record);
+#else
+        char *text = slot->text;
+        int level = slot->level;
+        int length = slot->length;
+#endif
+        if (panic) {
+            pfLoggerPanic((uint8_t *) text, (size_t) length);
+        } else {
+            LoggerOutput(level, (uint8_t *) text, (size_t) length);
+        }
+        // Release the slot to the producers for the next lap.
+        atomic_store_explicit(&slot->sequence, lap + LOGGER_RING_LENGTH, memory_order_release);
+        logger_ring_consume++;
+    }
+}
+
+#endif
+
+#if defined(LOGGER_ISR_ENABLED)
+
+#include <stdatomic.h>
+
+#if LOGGER_ISR_LENGTH < 2 || (LOGGER_ISR_LENGTH & (LOGGER_ISR_LENGTH - 1)) != 0
+#error "LOGGER_ISR_LENGTH must be a power of two of at least 2"
+#endif
+
+/**
+ * @brief A fixed-size record of LOGGER_ISR().
+ *
+ * @details The sequence tells who owns the record, like the sequence of a slot of the log ring.
+ */
+typedef struct
+{
+    atomic_uint_least32_t sequence;                                                     /**< Free or committed state */
+    const logger_isr_site_t *site;                                                      /**< Call site */
+    uint64_t timestamp;                                                                 /**< Tick count, LOGGER_TIMESTAMP_INVALID without tick source */
+    uint8_t count;                                                                      /**< Number of arguments */
+    uint32_t args[LOGGER_ISR_MAX_ARGS];                                                 /**< Arguments */
+}logger_isr_record_t;
+
+/**
+ * @brief Lock-free multi-producer, single-consumer ring of the records of LOGGER_ISR().
+ */
+static logger_isr_record_t logger_isr_ring[LOGGER_ISR_LENGTH];
+
+/**
+ * @brief Position of the next record to be reserved by LoggerIsr().
+ */
+static atomic_uint_least32_t logger_isr_reserve = 0;
+
+/**
+ * @brief Position of the next record to be printed by LoggerFlush().
+ */
+static uint_least32_t logger_isr_consume = 0;
+
+/**
+ * @brief Number of records dropped because the ring was full, reported by the next LoggerFlush().
+ */
+static atomic_uint_least32_t logger_isr_dropped = 0;
+
+/**
+ * @brief   Record a log of an interrupt handler, see LOGGER_ISR().
+ *
+ * @param[in] site    The call site.
+ * @param[in] args    The arguments.
+ * @param[in] count   The number of arguments, at most LOGGER_ISR_MAX_ARGS.
+ */
+void LoggerIsr(const logger_isr_site_t *site, const uint32_t *args, uint8_t count)
+{
+    uint_least32_t position = atomic_load_explicit(&logger_isr_reserve, memory_order_relaxed);
+    GetTicksFunction get_ticks = pfGetTicks;
+    logger_isr_record_t *record;
+
+    for (;;) {
+        record = &logger_isr_ring[position & (LOGGER_ISR_LENGTH - 1)];
+        uint_least32_t sequence = atomic_load_explicit(&record->sequence, memory_order_acquire);
+        int32_t difference = (int32_t)(sequence - (position & ~(uint_least32_t)(LOGGER_ISR_LENGTH - 1)));
+
+        if (difference == 0) {
+            // The record is free for this lap, try to take it.
+            if (atomic_compare_exchange_weak_explicit(&logger_isr_reserve, &position, position + 1,
+                    memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        }
+        else if (difference < 0) {
+            // The record still holds a log of the previous lap, so the ring is full.
+            atomic_fetch_add_explicit(&logger_isr_dropped, 1, memory_order_relaxed);
+            LOGGER_STATS_COUNT(dropped);
+            return;
+        }
+        else {
+            // A preempting handler took the record, try the next position.
+            position = atomic_load_explicit(&logger_isr_reserve, memory_order_relaxed);
+        }
+    }
+    record->site = site;
+    // The GetMilliseconds function has no bounded duration, so only a tick source gives the time of a record.
+    record->timestamp = (get_ticks != NULL) ? get_ticks() : LOGGER_TIMESTAMP_INVALID;
+    record->count = (count < LOGGER_ISR_MAX_ARGS) ? count : LOGGER_ISR_MAX_ARGS;
+    for (uint8_t index = 0; index < record->count; index++) {
+        record->args[index] = args[index];
+    }
+    // Publish the record to LoggerFlush().
+    atomic_store_explicit(&record->sequence, (position & ~(uint_least32_t)(LOGGER_ISR_LENGTH - 1)) + 1,
+            memory_order_release);
+}
+
+#if defined(LOGGER_TOKENIZED)
+
+/**
+ * @brief   Pack the arguments of a record of LOGGER_ISR() into a tokenized frame, like LoggerPackArgs().
+ *
+ * @param[out] buffer   The buffer that receives the arguments.
+ * @param[in]  size     The space available in the buffer.
+ * @param[in]  fmt      The format string of the log.
+ * @param[in]  args     The arguments.
+ * @param[in]  count    The number of arguments.
+ *
+ * @return  The number of bytes written.
+ */
+static size_t LoggerPackIsrArgs(uint8_t *buffer, size_t size, const char *fmt, const uint32_t *args, uint8_t count) {
+    size_t length = 0;
+    uint8_t index = 0;
+    logger_spec_t spec;
+
+    for (const char *p = strchr(fmt, '%'); p != NULL && index < count; p = strchr(p + spec.length, '%')) {
+        LoggerParseSpec(p, &spec);
+        for (uint8_t star = 0; star <= spec.stars && spec.type != LOGGER_ARG_NONE && index < count; star++) {
+            bool is_signed = (star < spec.stars) || spec.conversion == 'd' || spec.conversion == 'i';
+            int64_t integer = is_signed ? (int64_t)(int32_t) args[index] : (int64_t) args[index];
+            size_t written = LoggerPutVarint(buffer + length, size - length,
+                    is_signed ? ((uint64_t) integer << 1) ^ (uint64_t)(integer >> 63) : (uint64_t) integer);
+            if (written == 0) {
+                return length;
+            }
+            length += written;
+            index++;
+        }
+    }
+    return length;
+}
+
+#endif
+
+/**
+ * @brief   Format and print the committed records of LOGGER_ISR() in order and free them for the handlers.
+ *
+ * @param[in] panic   true to write the logs to the panic function, false to send them to the outputs.
+ */
+static void LoggerIsrDrain(bool panic) {
+    for (;;) {
+        logger_isr_record_t *record = &logger_isr_ring[logger_isr_consume & (LOGGER_ISR_LENGTH - 1)];
+        uint_least32_t lap = logger_isr_consume & ~(uint_least32_t)(LOGGER_ISR_LENGTH - 1);
+        uint32_t args[LOGGER_ISR_MAX_ARGS] = {0};
+
+        // Stop at the first record that is not committed yet.
+        if (atomic_load_explicit(&record->sequence, memory_order_acquire) != lap + 1) {
+            break;
+        }
+        const logger_isr_site_t *site = record->site;
+        uint64_t timestamp = (record->timestamp != LOGGER_TIMESTAMP_INVALID) ?
+                LoggerTicksToMicroseconds(record->timestamp) : LOGGER_TIMESTAMP_INVALID;
+        uint8_t count = record->count;
+        memcpy(args, record->args, count * sizeof(args[0]));
+        // Release the record before it is printed, so that the handlers can log in the meantime.
+        atomic_store_explicit(&record->sequence, lap + LOGGER_ISR_LENGTH, memory_order_release);
+        logger_isr_consume++;
+#if defined(LOGGER_TOKENIZED)
+        uint8_t *buffer = (uint8_t *) LoggerBuffer();
+        size_t length = LoggerTokenHeader(buffer, site->level, LoggerTokenize(site->file, site->line));
+        // Replace the time of the flush with the time of the record.
+        LoggerPutWord(buffer + 6, (timestamp != LOGGER_TIMESTAMP_INVALID) ? (uint32_t)(timestamp / 1000u) : 0);
+        length += LoggerPackIsrArgs(buffer + length, LOGGER_TOKEN_FRAME_MAX_LENGTH - length, site->fmt, args, count);
+        buffer[1] = (uint8_t)(length - 2);
+#else
+        char *buffer = LoggerBuffer();
+        int length = LoggerFormatHeader(buffer, LOGGER_BUFFER_MAX_LENGTH, site->level, timestamp,
+                GetFileNameFromPath(site->file), site->function, site->line);
+        int written = LOGGER_SNPRINTF(buffer + length, LOGGER_BUFFER_MAX_LENGTH - RESET_NEWLINE_LENGTH - length,
+                site->fmt, (unsigned int) args[0], (unsigned int) args[1], (unsigned int) args[2],
+                (unsigned int) args[3]);
+        if (written >= (int)(LOGGER_BUFFER_MAX_LENGTH - RESET_NEWLINE_LENGTH) - length) {
+            LOGGER_STATS_COUNT(truncated);
+        }
+        length = (written > 0) ? LoggerClampLength(length + written, LOGGER_BUFFER_MAX_LENGTH) : length;
+        length = LoggerTerminateLine(buffer, length);
+#endif
+        if (panic) {
+            pfLoggerPanic((uint8_t *) buffer, (size_t) length);
+        }
+        else {
+            LoggerOutput(site->level, (uint8_t *) buffer, (size_t) length);
+        }
+    }
+}
+
+#endif
+
+/**
+ * @brief   Write the logs that are still queued to the panic function.
+ *
+ * @details The records of LOGGER_ISR(), the log ring, the asynchronous buffers and the batch are written in this
+ *          order, oldest log first. Nothing is locked: the system is expected to stop or reset after the FATAL log
+ *          that follows.
+ */
+static void LoggerPanicDrain(void) {
+#if defined(LOGGER_ISR_ENABLED)
+    LoggerIsrDrain(true);
+#endif
+#if defined(LOGGER_RING)
+    LoggerRingDrain(true);
+#endif
+#if defined(LOGGER_ASYNC)
+    // The buffer being transmitted is written again, the transmission may not have completed.
+    uint_least32_t head = atomic_load(&logger_async_head);
+    for (uint_least32_t index = atomic_load(&logger_async_tail); index != head + 1; index++) {
+        uint32_t buffer = index % LOGGER_ASYNC_BUFFER_COUNT;
+        if (logger_async_lengths[buffer] > 0) {
+            pfLoggerPanic(logger_async_buffers[buffer], logger_async_lengths[buffer]);
+            logger_async_lengths[buffer] = 0;
+        }
+    }
+#elif defined(LOGGER_BATCH)
+    if (logger_batch_length > 0) {
+        pfLoggerPanic(logger_batch, logger_batch_length);
+        logger_batch_length = 0;
+    }
+#endif
+}
+
+/**
+ * @brief   Print a FATAL log through the panic function, after the logs that are still queued.
+ *
+ * @param[in] level      Log level.
+ * @param[in] file       The name of the file of the call site.
+ * @param[in] function   The name of the function of the call site, unused in tokenized mode.
+ * @param[in] line       The line of the call site.
+ * @param[in] token      The token of the call site in tokenized mode.
+ * @param[in] fmt        The format string of the log.
+ * @param[in] args       The arguments of the log.
+ */
+static void LoggerPanic(int level, const char *file, const char *function, int line, uint32_t token, const char *fmt,
+        va_list *args) {
+    LoggerPanicDrain();
+#if defined(LOGGER_TOKENIZED)
+    (void) file;
+    (void) function;
+    (void) line;
+    uint8_t *buffer = (uint8_t *) LoggerBuffer();
+    pfLoggerPanic(buffer, LoggerTokenFrame(buffer, level, token, fmt, args));
+#else
+    (void) token;
+    char *buffer = LoggerBuffer();
+    int length = LoggerFormatHeader(buffer, LOGGER_BUFFER_MAX_LENGTH, level, GetMicroseconds(), file, function, line);
+    length = LoggerFormatMessage(buffer, LOGGER_BUFFER_MAX_LENGTH, length, fmt, *args);
+    length = LoggerTerminateLine(buffer, length);
+    pfLoggerPanic((uint8_t *) buffer, (size_t) length);
+#endif
+}
+
+#if defined(LOGGER_DEFERRED)
+
+/**
+ * @brief This function records the format string and the arguments of a log so that it can be printed later by
+ *        LoggerFlush().
+ *
+ * @param level         Log level
+ * @param file          The name of the file in which the file is used.
+ * @param function      The name of the file in which the function is used.
+ * @param line          The name of the file in which the line is used.
+ * @param fmt           The string to be printed.
+ * @param ...           The argument to be printed.
  *
- * @note Log levels do not need to be in ascending order in this string.
- *       This is checked in automated unit testing prior to release.
  */
-static logger_desc_t const logger_array[] = {
-    {
-        .entity = LOGGER_ENTITY(DBG),
-        .color = "\x1b[37;1m" ///< White color for DEBUG log level.
-    },
-    {
-        .entity = LOGGER_ENTITY(INFO),
-        .color = "\x1b[32;1m" ///< Green color for INFO log level.
-    },
-    {
-        .entity = LOGGER_ENTITY(WARN),
-        .color = "\x1b[33;1m" ///< Yellow color for WARN log level.
-    },
-    {
-        .entity = LOGGER_ENTITY(ERR),
-        .color = "\x1b[31;1m" ///< Red color for ERR log level.
-    },
-    {
-        .entity = LOGGER_ENTITY(FATAL),
-        .color = "\x1b[31;1m" ///< Red color for FATAL log level.
+void LOG(int level, const char *file, const char *function, int line, const char *fmt, ...){
+    // Check if the log will be recorded.
+    if (level >= (int) lowest_log_level && level >= output_log_level){
+        // Write a FATAL log at once through the panic function, behind the logs still queued.
+        if (level >= (int) FATAL && pfLoggerPanic != NULL) {
+            va_list panic_args;
+            va_start(panic_args, fmt);
+            LoggerPanic(level, file, function, line, 0, fmt, &panic_args);
+            va_end(panic_args);
+            return;
+        }
+        uint64_t stats_start = LoggerStatsTicks();
+        logger_slot_t *slot = LoggerRingReserve();
+        // Drop the log if the ring is full.
+        if (slot == NULL) {
+            LoggerStatsLog(stats_start);
+            return;
+        }
+        logger_record_t *record = &slot->record;
+        record->fmt = fmt;
+        record->file = file;
+        record->function = function;
+        record->line = line;
+        record->timestamp = GetMicroseconds();
+        record->level = (uint8_t) level;
+        va_list args;
+        // Enables access to the variable arguments
+        va_start(args, fmt);
+        record->arg_words = LoggerCaptureArgs(fmt, &args, record->args);
+        // Performs cleanup for an ap object initialized by a call to va_start().
+        va_end(args);
+        // Publish the record to LoggerFlush().
+        LoggerRingCommit(slot);
+        LoggerStatsLog(stats_start);
+    } else {
+        LOGGER_STATS_FILTERED(level);
     }
-};
+}
+
+#elif defined(LOGGER_TOKENIZED)
 
 /**
- * @brief This variable determines the level of the logs to be printed.
+ * @brief This function sends a log as a compact tokenized frame instead of text. The host-side decoder rebuilds
+ *        the text from the token of the call site.
+ *
+ * @param level         Log level
+ * @param token         The cached token of the call site, calculated on the first call when it is zero.
+ * @param file          The name of the file in which the file is used.
+ * @param line          The name of the file in which the line is used.
+ * @param fmt           The string to be printed.
+ * @param ...           The argument to be printed.
+ *
  */
-logger_levels_t current_logger_level = DBG;
+void LOG_TOKENIZED(int level, uint32_t *token, const char *file, int line, const char *fmt, ...){
+    // Check if the log will be printed.
+    if (level >= (int) lowest_log_level && level >= output_log_level){
+        // Calculate the token once per call site.
+        if (*token == 0) {
+            *token = LoggerTokenize(file, line);
+        }
+        // Write a FATAL log at once through the panic function, behind the logs still queued.
+        if (level >= (int) FATAL && pfLoggerPanic != NULL) {
+            va_list panic_args;
+            va_start(panic_args, fmt);
+            LoggerPanic(level, file, NULL, line, *token, fmt, &panic_args);
+            va_end(panic_args);
+            return;
+        }
+        uint64_t stats_start = LoggerStatsTicks();
+#if defined(LOGGER_RING)
+        logger_slot_t *slot = LoggerRingReserve();
+        // Drop the log if the ring is full.
+        if (slot == NULL) {
+            LoggerStatsLog(stats_start);
+            return;
+        }
+        uint8_t *buffer = (uint8_t *) slot->text;
+#else
+        uint8_t *buffer = (uint8_t *) LoggerBuffer();
+#endif
+        va_list args;
+        // Enables access to the variable arguments
+        va_start(args, fmt);
+        size_t length = LoggerTokenFrame(buffer, level, *token, fmt, &args);
+        // Performs cleanup for an ap object initialized by a call to va_start().
+        va_end(args);
+#if defined(LOGGER_RING)
+        slot->level = level;
+        slot->length = (int) length;
+        // Publish the frame to LoggerFlush().
+        LoggerRingCommit(slot);
+#else
+        LoggerOutput(level, buffer, length);
+#endif
+        LoggerStatsLog(stats_start);
+    } else {
+        LOGGER_STATS_FILTERED(level);
+    }
+}
+
+#elif defined(LOGGER_RING)
 
 /**
- * @brief A literal string containing the color reset and newline characters.
+ * @brief This function formats the string to be printed and the argument with the information of the place where
+ *        it was printed into a slot of the log ring. The log is printed by LoggerFlush().
+ *
+ * @param level         Log level
+ * @param file          The name of the file in which the file is used.
+ * @param function      The name of the file in which the function is used.
+ * @param line          The name of the file in which the line is used.
+ * @param fmt           The string to be printed.
+ * @param ...           The argument to be printed.
+ *
+ */
+void LOG(int level, const char *file, const char *function, int line, const char *fmt, ...){
+    // Check if the log will be printed.
+    if (level >= (int) lowest_log_level && level >= output_log_level){
+        // Write a FATAL log at once through the panic function, behind the logs still queued.
+        if (level >= (int) FATAL && pfLoggerPanic != NULL) {
+            va_list panic_args;
+            va_start(panic_args, fmt);
+            LoggerPanic(level, file, function, line, 0, fmt, &panic_args);
+            va_end(panic_args);
+            return;
+        }
+        uint64_t stats_start = LoggerStatsTicks();
+        logger_slot_t *slot = LoggerRingReserve();
+        // Drop the log if the ring is full.
+        if (slot == NULL) {
+            LoggerStatsLog(stats_start);
+            return;
+        }
+        int length = LoggerFormatHeader(slot->text, sizeof(slot->text), level, GetMicroseconds(), file, function, line);
+        va_list args;
+        // Enables access to the variable arguments
+        va_start(args, fmt);
+        length = LoggerFormatMessage(slot->text, sizeof(slot->text), length, fmt, args);
+        // Performs cleanup for an ap object initialized by a call to va_start().
+        va_end(args);
+        slot->level = level;
+        slot->length = LoggerTerminateLine(slot->text, length);
+        // Publish the log to LoggerFlush().
+        LoggerRingCommit(slot);
+        LoggerStatsLog(stats_start);
+    } else {
+        LOGGER_STATS_FILTERED(level);
+    }
+}
+
+#else
+
+#if !defined(LOGGER_ASYNC)
+
+/**
+ * @brief Number of segments of a log passed to the vectored output function.
+ */
+#define LOGGER_SEGMENT_COUNT                                                        8
+
+/**
+ * @brief   Build a log segment.
+ */
+#define LOGGER_SEGMENT(pointer, length)                                             ((logger_segment_t){.p = (const uint8_t *)(pointer), .len = (length)})
+
+/**
+ * @brief   Clamp the return value of snprintf to the characters actually stored in the buffer.
+ *
+ * @param[in] written   The return value of snprintf.
+ * @param[in] size      The size of the buffer passed to snprintf.
+ *
+ * @return  The number of characters stored in the buffer.
  */
-const char* RESET_NEWLINE = "\n\r\x1b[0m";
+static size_t LoggerStoredLength(int written, size_t size) {
+    if (written < 0 || size == 0) {
+        return 0;
+    }
+    return ((size_t) written < size) ? (size_t) written : size - 1;
+}
+
+/**
+ * @brief   Print a log through the vectored output function.
+ *
+ * @details Only the timestamp, the line number and the message are formatted. The other segments point directly
+ *          to their storage or to the cached log prefixes, so they are not copied.
+ *
+ * @param[in] level       Log level.
+ * @param[in] timestamp   The elapsed time in microseconds when the log was produced.
+ * @param[in] file        The name of the file in which the log is used.
+ * @param[in] function    The name of the function in which the log is used.
+ * @param[in] line        The line in which the log is used.
+ * @param[in] fmt         The string to be printed.
+ * @param[in] args        The argument to be printed.
+ */
+static void LoggerWritev(int level, uint64_t timestamp, const char *file, const char *function, int line,
+        const char *fmt, va_list args) {
+    static const char separator[] = " : ";
+    const logger_prefix_t *prefix = LoggerGetPrefix(level);
+    char *buffer = LoggerBuffer();
+    char milliseconds[LOGGER_TIMESTAMP_MAX_LENGTH];
+    logger_segment_t segments[LOGGER_SEGMENT_COUNT];
+
+    // Format only the timestamp, the line number and the message, as far as the output profile has them.
+    bool bare = (log_profile == LOGGER_PROFILE_BARE);
+    bool compact = (log_profile == LOGGER_PROFILE_COMPACT);
+    size_t milliseconds_length = bare ? 0 : LoggerFormatTimestamp(milliseconds, timestamp);
+    size_t message_length = bare ? 0 : LoggerStoredLength(LOGGER_SNPRINTF(buffer, LOGGER_BUFFER_MAX_LENGTH,
+            compact ? ":%d " : " : %d -> ", line), LOGGER_BUFFER_MAX_LENGTH);
+    int written = LOGGER_VSNPRINTF(buffer + message_length, LOGGER_BUFFER_MAX_LENGTH - message_length, fmt, args);
+    if (written >= (int)(LOGGER_BUFFER_MAX_LENGTH - message_length)) {
+        LOGGER_STATS_COUNT(truncated);
+    }
+    message_length += LoggerStoredLength(written, LOGGER_BUFFER_MAX_LENGTH - message_length);
+
+    segments[0] = LOGGER_SEGMENT(prefix->prefix, prefix->prefix_length);
+    segments[1] = LOGGER_SEGMENT(milliseconds, milliseconds_length);
+    segments[2] = LOGGER_SEGMENT(prefix->level, prefix->level_length);
+    segments[3] = LOGGER_SEGMENT(file, bare ? 0 : strlen(file));
+    segments[4] = LOGGER_SEGMENT(separator, (bare || compact) ? 0 : sizeof(separator) - 1);
+    segments[5] = LOGGER_SEGMENT(function, (bare || compact) ? 0 : strlen(function));
+    segments[6] = LOGGER_SEGMENT(buffer, message_length);
+    segments[7] = LOGGER_SEGMENT(RESET_NEWLINE, LoggerNewlineLength());
+#if defined(LOGGER_THREAD_SAFE)
+    if (pfLoggerLock != NULL) {
+        pfLoggerLock();
+    }
+#endif
+#if defined(LOGGER_STATS)
+    logger_stats.emitted[level]++;
+    for (size_t segment = 0; segment < LOGGER_SEGMENT_COUNT; segment++) {
+        logger_stats.bytes += segments[segment].len;
+    }
+#endif
+    uint64_t start = LoggerStatsTicks();
+    pfLoggerWritev(segments, LOGGER_SEGMENT_COUNT);
+    LoggerStatsOutput(start);
+#if defined(LOGGER_THREAD_SAFE)
+    if (pfLoggerUnlock != NULL) {
+        pfLoggerUnlock();
+    }
+#endif
+}
+
+#endif
 
 /**
  * @brief This function prints the string to be printed and the argument with the information of the place where it
@@ -296,93 +3599,401 @@ const char* RESET_NEWLINE = "\n\r\x1b[0m";
  */
 void LOG(int level, const char *file, const char *function, int line, const char *fmt, ...){
     // Check if the log will be printed.
-    if (level >= GetCurrentLogLevel()){
-    	// Clear buffer before write to log.
-        memset(logger_buffer, 0x00, sizeof(logger_buffer));
-        // Set the default log syntax.
-        int length = snprintf(logger_buffer, sizeof(logger_buffer), "%s%s[%0.1f] : %s : %s : %s : %d -> ",
-        		logger_array[level].color,
-				GetAppName(),
-				GetMilliseconds(),
-				logger_array[level].entity.name,
-				GetFileNameFromPath(file),
-				function,
-				line);
+    if (level >= (int) lowest_log_level && level >= output_log_level){
+        // Write a FATAL log at once through the panic function, behind the logs still queued.
+        if (level >= (int) FATAL && pfLoggerPanic != NULL) {
+            va_list panic_args;
+            va_start(panic_args, fmt);
+            LoggerPanic(level, file, function, line, 0, fmt, &panic_args);
+            va_end(panic_args);
+            return;
+        }
+        uint64_t stats_start = LoggerStatsTicks();
         va_list args;
+#if !defined(LOGGER_ASYNC)
+        // Hand the pieces of the log to the vectored output function without copying them. The sinks need the
+        // complete log, so it is printed through the LoggerPrintf function while sinks are registered.
+        if (pfLoggerWritev != NULL && logger_sink_count == 0) {
+            va_start(args, fmt);
+            LoggerWritev(level, GetMicroseconds(), file, function, line, fmt, args);
+            va_end(args);
+            LoggerStatsLog(stats_start);
+            return;
+        }
+#endif
+        char *buffer = LoggerBuffer();
+        int length = LoggerFormatHeader(buffer, LOGGER_BUFFER_MAX_LENGTH, level, GetMicroseconds(), file, function, line);
         // Enables access to the variable arguments
         va_start(args, fmt);
-        // Calculate the remaining space in the buffer after the initial log message.
-        size_t size = sizeof(logger_buffer) - sizeof(RESET_NEWLINE) - length;
-        // Check if there is space available in the buffer for additional characters.
-        if (size > 0) {
-            // Try to write the formatted log message to the buffer with the remaining space.
-            int written = vsnprintf(logger_buffer + length, size, fmt, args);
-            // Update the length with the actual number of characters written.
-            if (written > 0) {
-                // If more characters were written than the remaining space, update the length accordingly.
-                if (written > size)
-                    length += size;
-                else
-                    length += written;
-            }
-        }
+        length = LoggerFormatMessage(buffer, LOGGER_BUFFER_MAX_LENGTH, length, fmt, args);
         // Performs cleanup for an ap object initialized by a call to va_start().
         va_end(args);
-        // Delete the color of the log level for the next log.
-        snprintf(logger_buffer + length, sizeof(logger_buffer) - length, "%s", RESET_NEWLINE);
+        length = LoggerTerminateLine(buffer, length);
         // Print the all logs.
-        LoggerPrintf((uint8_t *) logger_buffer, length + sizeof(RESET_NEWLINE));
-	}
+        LoggerOutput(level, (uint8_t *) buffer, length);
+        LoggerStatsLog(stats_start);
+	} else {
+        LOGGER_STATS_FILTERED(level);
+    }
+}
+
+#endif
+
+#if defined(LOGGER_TOKENIZED)
+
+/**
+ * @brief This function sends a hex dump as tokenized frames. Every frame carries the offset of its first byte as a
+ *        varint and as many bytes as fit, as a varint length followed by the bytes.
+ *
+ * @param level         Log level
+ * @param token         The cached token of the call site, calculated on the first call when it is zero.
+ * @param file          The name of the file in which the file is used.
+ * @param line          The name of the file in which the line is used.
+ * @param data          The bytes to be dumped.
+ * @param len           The number of bytes.
+ *
+ */
+void LOG_HEXDUMP_TOKENIZED(int level, uint32_t *token, const char *file, int line, const void *data, size_t len){
+    // Check if the log will be printed.
+    if (level >= (int) lowest_log_level && level >= output_log_level){
+        // Calculate the token once per call site.
+        if (*token == 0) {
+            *token = LoggerTokenize(file, line);
+        }
+        // Room for the offset (up to 5 bytes) and the length (up to 2 bytes) of the bytes.
+        const size_t chunk = LOGGER_TOKEN_FRAME_MAX_LENGTH - LOGGER_TOKEN_HEADER_LENGTH - 7;
+        const uint8_t *bytes = (const uint8_t *) data;
+        // Write a FATAL dump at once through the panic function, behind the logs still queued.
+        bool panic = (level >= (int) FATAL && pfLoggerPanic != NULL);
+        if (panic) {
+            LoggerPanicDrain();
+        }
+        for (size_t offset = 0; offset < len; offset += chunk) {
+            size_t count = (len - offset < chunk) ? len - offset : chunk;
+            uint8_t *buffer = (uint8_t *) LoggerBuffer();
+#if defined(LOGGER_RING)
+            logger_slot_t *slot = NULL;
+            if (!panic) {
+                slot = LoggerRingReserve();
+                // Drop the rest of the dump if the ring is full.
+                if (slot == NULL) {
+                    return;
+                }
+                buffer = (uint8_t *) slot->text;
+            }
+#endif
+            size_t length = LoggerTokenHeader(buffer, level, *token);
+            length += LoggerPutVarint(buffer + length, 5, (uint32_t) offset);
+            length += LoggerPutVarint(buffer + length, 2, count);
+            memcpy(buffer + length, bytes + offset, count);
+            length += count;
+            buffer[1] = (uint8_t)(length - 2);
+            if (panic) {
+                pfLoggerPanic(buffer, length);
+                continue;
+            }
+#if defined(LOGGER_RING)
+            slot->level = level;
+            slot->length = (int) length;
+            // Publish the frame to LoggerFlush().
+            LoggerRingCommit(slot);
+#else
+            LoggerOutput(level, buffer, length);
+#endif
+        }
+    } else {
+        LOGGER_STATS_FILTERED(level);
+    }
+}
+
+#else
+
+/**
+ * @brief Number of bytes recorded per row of a hex dump, limited in deferred mode by the argument words of a record.
+ */
+#if defined(LOGGER_DEFERRED) && LOGGER_DEFERRED_MAX_ARG_WORDS * 4 < LOGGER_HEXDUMP_ROW_BYTES
+#define LOGGER_HEXDUMP_STEP                                                         (LOGGER_DEFERRED_MAX_ARG_WORDS * 4)
+#else
+#define LOGGER_HEXDUMP_STEP                                                         LOGGER_HEXDUMP_ROW_BYTES
+#endif
+
+/**
+ * @brief   Print a row of a hex dump, or record it in ring and deferred modes.
+ *
+ * @details In deferred mode the bytes are copied into the argument words of the record and the offset is stored as
+ *          its line, so that the data does not have to stay valid until LoggerFlush().
+ *
+ * @param[in] level    Log level.
+ * @param[in] offset   The offset of the row in the dump.
+ * @param[in] data     The bytes of the row.
+ * @param[in] count    The number of bytes of the row, at most LOGGER_HEXDUMP_STEP.
+ *
+ * @return  false if the ring is full, true otherwise.
+ */
+static bool LoggerHexdumpRow(int level, uint32_t offset, const uint8_t *data, size_t count) {
+    // The rows of a FATAL dump follow its first log, see LOG().
+    if (level >= (int) FATAL && pfLoggerPanic != NULL) {
+        char *buffer = LoggerBuffer();
+        pfLoggerPanic((uint8_t *) buffer, (size_t) LoggerFormatHexRow(buffer, level, offset, data, count));
+        return true;
+    }
+#if defined(LOGGER_DEFERRED)
+    logger_slot_t *slot = LoggerRingReserve();
+    if (slot == NULL) {
+        return false;
+    }
+    logger_record_t *record = &slot->record;
+    record->fmt = logger_hexdump_row;
+    record->line = (int) offset;
+    record->level = (uint8_t) level;
+    record->arg_words = (uint8_t) count;
+    memcpy(record->args, data, count);
+    LoggerRingCommit(slot);
+#elif defined(LOGGER_RING)
+    logger_slot_t *slot = LoggerRingReserve();
+    if (slot == NULL) {
+        return false;
+    }
+    slot->level = level;
+    slot->length = LoggerFormatHexRow(slot->text, level, offset, data, count);
+    LoggerRingCommit(slot);
+#else
+    char *buffer = LoggerBuffer();
+    LoggerOutput(level, (uint8_t *) buffer, LoggerFormatHexRow(buffer, level, offset, data, count));
+#endif
+    return true;
+}
+
+/**
+ * @brief This function prints a hex dump: one log with the default log syntax and the size of the dump, then one
+ *        row per LOGGER_HEXDUMP_ROW_BYTES bytes with the offset, the bytes in hexadecimal and in ASCII.
+ *
+ * @param level         Log level
+ * @param file          The name of the file in which the file is used.
+ * @param function      The name of the file in which the function is used.
+ * @param line          The name of the file in which the line is used.
+ * @param data          The bytes to be dumped.
+ * @param len           The number of bytes.
+ *
+ */
+void LOG_HEXDUMP(int level, const char *file, const char *function, int line, const void *data, size_t len){
+    // Check if the log will be printed.
+    if (level >= (int) lowest_log_level && level >= output_log_level){
+        const uint8_t *bytes = (const uint8_t *) data;
+        LOG(level, file, function, line, "hexdump of %lu bytes", (unsigned long) len);
+        for (size_t offset = 0; offset < len; offset += LOGGER_HEXDUMP_STEP) {
+            size_t count = (len - offset < LOGGER_HEXDUMP_STEP) ? len - offset : LOGGER_HEXDUMP_STEP;
+            // Drop the rest of the dump if the ring is full.
+            if (!LoggerHexdumpRow(level, (uint32_t) offset, bytes + offset, count)) {
+                break;
+            }
+        }
+    } else {
+        LOGGER_STATS_FILTERED(level);
+    }
 }
 
+#endif
+
+#if defined(LOGGER_RING)
+
+/**
+ * @brief   Print the pending logs.
+ *
+ * @details This function is the consumer of the log ring. It prints every committed slot in order through the
+ *          registered LoggerPrintf function and frees it for the producers. It stops at the first slot that is
+ *          not committed yet. The records of LOGGER_ISR() are printed first with LOGGER_ISR_ENABLED. In deferred
+ *          mode the records are formatted here. It must not be called from more than one context at a time.
+ */
+void LoggerFlush(void) {
+#if defined(LOGGER_ISR_ENABLED)
+    LoggerIsrDrain(false);
+#endif
+    LoggerRingDrain(false);
+    // Report the logs that could not be recorded.
+    uint32_t dropped = atomic_exchange_explicit(&logger_dropped_logs, 0, memory_order_relaxed);
+#if defined(LOGGER_ISR_ENABLED)
+    dropped += atomic_exchange_explicit(&logger_isr_dropped, 0, memory_order_relaxed);
+#endif
+    LoggerReportDropped(dropped);
+#if defined(LOGGER_ASYNC)
+    LoggerAsyncKick();
+#elif defined(LOGGER_BATCH)
+    LoggerBatchSync();
+#endif
+}
+
+#endif
+
 #elif defined(HARD_FAULT_LOGGER_ENABLED)
 
-#include <math.h>
-#include <stdio.h>
-#include <stdint.h>
-#include <string.h>
+/**
+ * @brief   Calculate the file id of a breadcrumb.
+ *
+ * @details The id is the FNV-1a hash of the file name without its directories, folded to 16 bits. The path is
+ *          scanned once and the hash restarts after every separator, so no C library call is needed.
+ *
+ * @param[in] file   The path of the source file.
+ *
+ * @return  The file id.
+ */
+static uint16_t LoggerFileId(const char *file) {
+    uint32_t hash = 0x811C9DC5u;
+
+    for (const char *p = file; *p != '\0'; p++) {
+        if (*p == '/' || *p == '\\') {
+            hash = 0x811C9DC5u;
+        } else {
+            hash = (hash ^ (uint8_t) *p) * 0x01000193u;
+        }
+    }
+    return (uint16_t)(hash ^ (hash >> 16));
+}
+
+/**
+ * @brief   Get the checksum contribution of a trail entry.
+ *
+ * @param[in] breadcrumb   The entry.
+ *
+ * @return  The entry as a 32-bit word.
+ */
+static uint32_t LoggerBreadcrumbWord(const logger_breadcrumb_t *breadcrumb) {
+    return ((uint32_t) breadcrumb->line << 16) | breadcrumb->file_id;
+}
+
+/**
+ * @brief   Get the checksum contribution of the head and count of the trail.
+ *
+ * @return  The head and count as a 32-bit word.
+ */
+static uint32_t LoggerTrailWord(void) {
+    return ((uint32_t) logger_trail.head << 16) | logger_trail.count;
+}
+
+/**
+ * @brief   Check that the header of the trail can be trusted.
+ *
+ * @details Only the magic and the indices are checked, which is enough to write the next entry safely.
+ *
+ * @return  true if the trail has been started and its indices are in range, false otherwise.
+ */
+static bool LoggerTrailStarted(void) {
+    return logger_trail.magic == LOGGER_TRAIL_MAGIC && logger_trail.head < LOGGER_BREADCRUMB_COUNT &&
+           logger_trail.count <= LOGGER_BREADCRUMB_COUNT;
+}
+
+/**
+ * @brief   Start an empty trail.
+ */
+static void LoggerTrailStart(void) {
+    logger_trail.head = 0;
+    logger_trail.count = 0;
+    logger_trail.checksum = LoggerTrailWord();
+    logger_trail.magic = LOGGER_TRAIL_MAGIC;
+}
 
 /**
  * @brief   Log a message with file and line information.
  *
  * @details This function logs a message with information about the source file
- *          and line number where the log occurred. It appends the file name,
- *          line number, and a separator to the logger buffer. The stored logs
- *          in the buffer are managed to prevent overflow.
+ *          and line number where the log occurred. The entry is written over the
+ *          oldest one when the trail is full, so every call takes constant time.
+ *          A trail that has not been started, e.g. uninitialized no-init memory,
+ *          is started first.
  *
  * @param[in] file   A pointer to the source file name.
  * @param[in] line   The line number in the source file.
  */
 void LOG(const char *file, int line) {
-    const char separator[1] = "-";  ///< Separator character between file and line
-    const int length_of_line = (line == 0 ? 1 : ((int)(log10(fabs(line)) + 1) + (line < 0 ? 1 : 0)));
-    const int new_log_length = strlen(GetFileNameFromPath(file)) + length_of_line + sizeof(separator);
-
-    int length_of_stored_log = (strrchr(logger_buffer, separator[0]) == NULL ? 0 : strrchr(logger_buffer, separator[0]) - logger_buffer + 1);
-
-    // Clear buffer before saving the first log.
-    if (length_of_stored_log == 0) {
-        memset(logger_buffer, 0x00, sizeof(logger_buffer));
-    }
-    // Unhandled statement
-    else if (length_of_stored_log > sizeof(logger_buffer) / sizeof(logger_buffer[0])) {
-        memset(logger_buffer, 0x00, sizeof(logger_buffer));
-        return;
+    if (!LoggerTrailStarted()) {
+        LoggerTrailStart();
     }
-    // If there is not enough space for a new log in the buffer
-    else if (new_log_length > (sizeof(logger_buffer) / sizeof(logger_buffer[0])) - length_of_stored_log) {
-        do {
-            int latest_stored_log_length = (strchr(logger_buffer, separator[0]) == NULL ? 0 : strchr(logger_buffer, separator[0]) - logger_buffer + 1);
-            memcpy(logger_buffer, logger_buffer + latest_stored_log_length, (sizeof(logger_buffer) / sizeof(logger_buffer[0])) - latest_stored_log_length);
-            memset(logger_buffer + (sizeof(logger_buffer) / sizeof(logger_buffer[0])) - latest_stored_log_length, 0x00, latest_stored_log_length);
-            length_of_stored_log = (strrchr(logger_buffer, separator[0]) == NULL ? 0 : strrchr(logger_buffer, separator[0]) - logger_buffer + 1);
-        } while (new_log_length > (sizeof(logger_buffer) / sizeof(logger_buffer[0])) - length_of_stored_log);
+    logger_breadcrumb_t *breadcrumb = &logger_trail.entries[logger_trail.head];
+    uint32_t checksum = logger_trail.checksum - LoggerTrailWord();
+
+    // The oldest entry leaves the checksum when it is overwritten.
+    if (logger_trail.count == LOGGER_BREADCRUMB_COUNT) {
+        checksum -= LoggerBreadcrumbWord(breadcrumb);
+    } else {
+        logger_trail.count++;
     }
+    breadcrumb->file_id = LoggerFileId(file);
+    breadcrumb->line = (line <= 0) ? 1 : (line > UINT16_MAX) ? UINT16_MAX : (uint16_t) line;
+
+    logger_trail.head = (logger_trail.head + 1 < LOGGER_BREADCRUMB_COUNT) ? logger_trail.head + 1 : 0;
+    logger_trail.checksum = checksum + LoggerBreadcrumbWord(breadcrumb) + LoggerTrailWord();
+}
+
+/**
+ * @brief   Recover the trail of the previous boot.
+ *
+ * @details The magic, the indices and the checksum of the whole trail are checked before the entries are copied.
+ *          A new trail is started in any case.
+ *
+ * @param[out] breadcrumbs   The array where the entries will be copied.
+ * @param[in]  size          The number of entries the array can hold.
+ *
+ * @return  The number of entries copied, or 0 if there is no valid trail.
+ */
+uint16_t LoggerRecoverCrashLog(logger_breadcrumb_t *breadcrumbs, uint16_t size) {
+    uint16_t recovered = 0;
+
+    if (LoggerTrailStarted()) {
+        uint16_t oldest = (uint16_t)((logger_trail.head + LOGGER_BREADCRUMB_COUNT - logger_trail.count) % LOGGER_BREADCRUMB_COUNT);
+        uint32_t checksum = LoggerTrailWord();
 
-    // Append the file name, line number, and separator to the logger buffer.
-    snprintf(logger_buffer + length_of_stored_log, sizeof(logger_buffer) - length_of_stored_log, "%s%u%s", GetFileNameFromPath(file), line, separator);
+        for (uint16_t i = 0; i < logger_trail.count; i++) {
+            checksum += LoggerBreadcrumbWord(&logger_trail.entries[(oldest + i) % LOGGER_BREADCRUMB_COUNT]);
+        }
+        if (checksum == logger_trail.checksum && breadcrumbs != NULL) {
+            // Keep the newest entries if the array is too small.
+            recovered = (logger_trail.count < size) ? logger_trail.count : size;
+            for (uint16_t i = 0; i < recovered; i++) {
+                breadcrumbs[i] = logger_trail.entries[(oldest + logger_trail.count - recovered + i) % LOGGER_BREADCRUMB_COUNT];
+            }
+        }
+    }
+    LoggerTrailStart();
+    return recovered;
 }
 
 #else
 
 #endif
+
+#if !defined(LOGGER_RING)
+
+/**
+ * @brief   Print the pending logs.
+ *
+ * @details Logs are printed immediately when they are not queued in the log ring, so there is nothing to flush
+ *          but the records of LOGGER_ISR() with LOGGER_ISR_ENABLED. In asynchronous mode the buffer being filled is
+ *          handed to the output if it is idle, and in batched mode the batch is printed.
+ */
+void LoggerFlush(void) {
+#if defined(LOGGER_ISR_ENABLED)
+    LoggerIsrDrain(false);
+    LoggerReportDropped(atomic_exchange_explicit(&logger_isr_dropped, 0, memory_order_relaxed));
+#elif defined(LOGGER_ASYNC) && defined(LOGGER_ENABLED)
+    LoggerReportDropped(0);
+#endif
+#if defined(LOGGER_ASYNC) && defined(LOGGER_ENABLED)
+    LoggerAsyncKick();
+#elif defined(LOGGER_BATCH)
+    LoggerBatchSync();
+#endif
+}
+
+#endif
+
+#if !defined(LOGGER_ASYNC) || !defined(LOGGER_ENABLED)
+
+/**
+ * @brief   Signal the end of an asynchronous transmission.
+ *
+ * @details Transmissions are synchronous outside of asynchronous mode, so there is nothing to do.
+ */
+void LoggerTxComplete(void) {
+}
+
+#endif
@@ -14,6 +14,161 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+/**
+ * @brief Deferred formatting mode.
+ *
+ * @details When LOGGER_DEFERRED is defined, LOGGER() only records the format string, the call site, the timestamp
+ *          and the raw argument words into a binary record. The text is formatted later by LoggerFlush(), which
+ *          should be called from a background task. Deferred mode implies LOGGER_RING and LOGGER_ENABLED.
+ *
+ * @note    Arguments passed for %s are stored as pointers, so the strings must stay valid until LoggerFlush()
+ *          has printed the record.
+ */
+#if defined(LOGGER_DEFERRED) && !defined(LOGGER_RING)
+#define LOGGER_RING
+#endif
+
+/**
+ * @brief Log ring mode.
+ *
+ * @details When LOGGER_RING is defined, LOG() writes every log into its own slot of a lock-free multi-producer
+ *          ring instead of the shared logger buffer, so tasks and interrupts can log at the same time without a
+ *          mutex. The slots are printed in order by LoggerFlush(). Logs are dropped and counted while the ring is
+ *          full. Ring mode implies LOGGER_ENABLED.
+ *
+ * @note    The ring relies on lock-free 32-bit C11 atomics (e.g. ARMv7-M and later).
+ */
+#if defined(LOGGER_RING) && !defined(LOGGER_ENABLED)
+#define LOGGER_ENABLED
+#endif
+
+/**
+ * @brief Interrupt log records.
+ *
+ * @details When LOGGER_ISR_ENABLED is defined, LOGGER_ISR() copies its call site, the tick count and up to four
+ *          integer arguments into a fixed-size record of a small lock-free ring, in bounded time and without
+ *          formatting. The records are formatted and printed by LoggerFlush(), which must then be called
+ *          periodically. The time of a record is only taken from a tick source registered with
+ *          LoggerRegisterTicksFunction(), never from the GetMilliseconds function, whose duration is unknown;
+ *          without one the records are printed with the time -1.0, or 0 in tokenized mode. Without
+ *          LOGGER_ISR_ENABLED, LOGGER_ISR() works like LOGGER(). It implies LOGGER_ENABLED.
+ *
+ * @note    The ring relies on lock-free 32-bit C11 atomics (e.g. ARMv7-M and later).
+ */
+#if defined(LOGGER_ISR_ENABLED) && !defined(LOGGER_ENABLED)
+#define LOGGER_ENABLED
+#endif
+
+/**
+ * @brief Tokenized output mode.
+ *
+ * @details When LOGGER_TOKENIZED is defined, LOGGER() sends a compact binary frame instead of text: a token that
+ *          identifies the call site, the timestamp, the level and the packed arguments. The host-side decoder
+ *          (tools/logger_decode.py) builds the string table of the tokens from the sources and rebuilds the text.
+ *          It can be combined with LOGGER_RING. Tokenized mode implies LOGGER_ENABLED.
+ */
+#if defined(LOGGER_TOKENIZED) && defined(LOGGER_DEFERRED)
+#error "LOGGER_TOKENIZED cannot be combined with LOGGER_DEFERRED"
+#endif
+
+#if defined(LOGGER_TOKENIZED) && !defined(LOGGER_ENABLED)
+#define LOGGER_ENABLED
+#endif
+
+/**
+ * @brief Asynchronous output mode.
+ *
+ * @details When LOGGER_ASYNC is defined, complete logs are copied into one of several output buffers instead of
+ *          being printed while LOG() waits. The LoggerPrintf function is then expected to start the transmission
+ *          of the buffer (e.g. with DMA) and return at once. LoggerTxComplete() must be called when it is done,
+ *          typically from the transmission interrupt, to switch to the next buffer. Every buffer holds
+ *          LOGGER_ASYNC_BUFFER_SIZE bytes, LOGGER_BUFFER_MAX_LENGTH by default, and is passed whole to a function
+ *          registered with LoggerRegisterWriteFunction(). Without one, the buffers are filled with at most 255
+ *          bytes, so that each of them is a single call of the LoggerPrintf function and a single transmission.
+ *          Logs that do not fit into a free buffer are dropped and reported by LoggerFlush(). LOG() must not be
+ *          called from code that preempts another LOG(), unless LOGGER_RING is defined as well. Asynchronous mode
+ *          implies LOGGER_ENABLED.
+ */
+#if defined(LOGGER_ASYNC) && !defined(LOGGER_ENABLED)
+#define LOGGER_ENABLED
+#endif
+
+/**
+ * @brief Batched output mode.
+ *
+ * @details When LOGGER_BATCH is defined, complete logs are collected into a batch buffer of LOGGER_BATCH_SIZE bytes
+ *          (512 by default) and handed to the output in one call, which saves the per-call overhead of packetized
+ *          transports such as USB CDC or UDP. The batch is printed when the next log does not fit, as soon as a log
+ *          of level ERR or above is added, when a log is added more than LOGGER_BATCH_TIMEOUT_MS milliseconds
+ *          (100 by default) after the first log of the batch, and by LoggerFlush(), which should be called
+ *          periodically to bound the delay of the last logs. Batches larger than 255 bytes are passed whole to a
+ *          function registered with LoggerRegisterWriteFunction(). The sinks and the vectored output function are
+ *          not batched. Batched mode implies LOGGER_ENABLED and cannot be combined with LOGGER_ASYNC, whose output
+ *          buffers already collect the logs.
+ */
+#if defined(LOGGER_BATCH) && defined(LOGGER_ASYNC)
+#error "LOGGER_BATCH cannot be combined with LOGGER_ASYNC"
+#endif
+
+#if defined(LOGGER_BATCH) && !defined(LOGGER_ENABLED)
+#define LOGGER_ENABLED
+#endif
+
+/**
+ * @brief Built-in formatter.
+ *
+ * @details When LOGGER_TINY_PRINTF is defined, the logs are formatted by a small formatter built into the logger
+ *          instead of the snprintf and vsnprintf of the C library. It supports %d %i %u %x %X %o %s %c %p and %%
+ *          with flags, width, precision and length modifiers. Define LOGGER_TINY_PRINTF_FLOAT, which implies
+ *          LOGGER_TINY_PRINTF, to print %f as fixed-point as well.
+ */
+#if defined(LOGGER_TINY_PRINTF_FLOAT) && !defined(LOGGER_TINY_PRINTF)
+#define LOGGER_TINY_PRINTF
+#endif
+
+/**
+ * @brief Thread-safe mode.
+ *
+ * @details When LOGGER_THREAD_SAFE is defined, LOG() formats every log in a logger buffer of the calling context
+ *          instead of the single shared one, so that tasks and cores format their logs in parallel. Only the handoff
+ *          to the output is serialized, through the lock functions registered with LoggerRegisterThreadFunctions().
+ *          The buffer is selected by the registered GetContext function, e.g. the core number or a task slot,
+ *          among LOGGER_CONTEXT_COUNT buffers (2 by default). Contexts that can preempt each other must get
+ *          different buffers. Define LOGGER_THREAD_LOCAL as well to use a C11 thread-local buffer per thread
+ *          instead, on hosts and RTOSes that support it.
+ */
+#if defined(LOGGER_THREAD_SAFE) && !defined(LOGGER_CONTEXT_COUNT)
+#define LOGGER_CONTEXT_COUNT                                                        2
+#endif
+
+/**
+ * @brief Flash log store.
+ *
+ * @details When LOGGER_FLASH is defined, LoggerFlashInit() registers a sink that appends the logs to a ring of
+ *          flash sectors, so that the logs written while no host is attached can be read back later with
+ *          LoggerFlashNext(). The logs are collected in a RAM page of LOGGER_FLASH_PAGE_SIZE bytes (256 by default)
+ *          and programmed a page at a time. When the last sector is full the oldest one is erased and reused.
+ */
+#if defined(LOGGER_FLASH) && !defined(LOGGER_FLASH_PAGE_SIZE)
+#define LOGGER_FLASH_PAGE_SIZE                                                      256
+#endif
+
+/**
+ * @brief Maximum length of a log, including the color codes and the line ending.
+ *
+ * @details It can be set from the build, e.g. -DLOGGER_BUFFER_MAX_LENGTH=1024, and sets the size of the logger
+ *          buffer. Logs longer than 255 bytes are passed whole to a function registered with
+ *          LoggerRegisterWriteFunction(), and in pieces of at most 255 bytes to the LoggerPrintf function and to
+ *          the sinks.
+ */
+#ifndef LOGGER_BUFFER_MAX_LENGTH
+#define LOGGER_BUFFER_MAX_LENGTH                                                    256
+#endif
+
+#if LOGGER_BUFFER_MAX_LENGTH < 64
+#error "LOGGER_BUFFER_MAX_LENGTH must be at least 64"
+#endif
+
 /**
  * @brief Level of logger
  */
@@ -45,6 +200,17 @@ typedef enum
 	FATAL,
 }logger_levels_t;
 
+/**
+ * @brief Minimum log level compiled into the application.
+ *
+ * @details LOGGER() calls with a constant level below LOGGER_MIN_LEVEL are removed by the compiler together with
+ *          their format strings and arguments. The runtime level set by SetCurrentLogLevel() still applies to the
+ *          remaining calls. It can be set from the build, e.g. -DLOGGER_MIN_LEVEL=WARN.
+ */
+#ifndef LOGGER_MIN_LEVEL
+#define LOGGER_MIN_LEVEL DBG
+#endif
+
 /**
  * @brief Function pointer type to obtain the elapsed time in milliseconds.
  *
@@ -54,6 +220,21 @@ typedef enum
  */
 typedef float (*GetMillisecondsFunction)(void);
 
+/**
+ * @brief Function pointer type to obtain the elapsed time as an integer tick count.
+ *
+ * @details This function pointer type is used to define the signature of a function
+ *          that retrieves a monotonic tick counter, such as a SysTick or microsecond timer.
+ *          A 32-bit counter can be returned as it is. The function should take no parameters
+ *          and return the tick count (uint64_t).
+ */
+typedef uint64_t (*GetTicksFunction)(void);
+
+/**
+ * @brief Value returned by GetMicroseconds() when no time source is registered.
+ */
+#define LOGGER_TIMESTAMP_INVALID                                                    UINT64_MAX
+
 /**
  * @brief Function pointer type to print formatted log messages.
  *
@@ -64,6 +245,60 @@ typedef float (*GetMillisecondsFunction)(void);
  */
 typedef void (*LoggerPrintfFunction)(const uint8_t* p, uint8_t len);
 
+/**
+ * @brief Function pointer type to print log messages of any length.
+ *
+ * @details Same as LoggerPrintfFunction, with a size_t length, so that logs longer than 255 bytes are passed
+ *          in one call.
+ */
+typedef void (*LoggerWriteFunction)(const uint8_t* p, size_t len);
+
+/**
+ * @brief A contiguous piece of a log message.
+ */
+typedef struct
+{
+    const uint8_t* p;                                                                   /**< Start of the segment */
+    size_t len;                                                                         /**< Length of the segment */
+}logger_segment_t;
+
+/**
+ * @brief Function pointer type to print a log message made of several segments.
+ *
+ * @details This function pointer type is used to define the signature of a function
+ *          that prints a log message given as an array of segments, e.g. to hand them to
+ *          a scatter-gather DMA. The constant parts of the message (level color, application
+ *          name, level name, file and function names, color reset) point directly to their
+ *          storage. The other parts point into the logger buffer, which is reused by the next
+ *          log, so they must be consumed before the function returns.
+ */
+typedef void (*LoggerWritevFunction)(const logger_segment_t* segments, uint8_t count);
+
+/**
+ * @brief Function pointer type to obtain the index of the calling context in thread-safe mode.
+ *
+ * @details The function should return a value below LOGGER_CONTEXT_COUNT that is unique among the contexts that
+ *          can log at the same time, such as the core number.
+ */
+typedef uint8_t (*GetContextFunction)(void);
+
+/**
+ * @brief Function pointer type to take or release the output lock in thread-safe mode.
+ */
+typedef void (*LoggerLockFunction)(void);
+
+/**
+ * @brief One entry of the hard fault logger trail (HARD_FAULT_LOGGER_ENABLED).
+ *
+ * @details file_id is the 16-bit FNV-1a hash of the file name, folded from 32 bits, and can be mapped back to
+ *          the file name with tools/logger_decode.py. Unused entries have a line of 0.
+ */
+typedef struct
+{
+    uint16_t file_id;                                                                   /**< Hash of the file name */
+    uint16_t line;                                                                      /**< Line number, saturated to 65535 */
+}logger_breadcrumb_t;
+
 /**
  * @brief   Get the elapsed time in milliseconds.
  *
@@ -89,6 +324,18 @@ float GetMilliseconds(void);
  */
 void LoggerPrintf(const uint8_t* p, uint8_t len);
 
+/**
+ * @brief   Print a buffer of any length.
+ *
+ * @details The buffer is passed whole to the function registered with LoggerRegisterWriteFunction(). Otherwise
+ *          it is streamed to the LoggerPrintf function in pieces of at most 255 bytes, so that long payloads
+ *          such as hex dumps can be printed without a larger buffer.
+ *
+ * @param[in] p   A pointer to the buffer.
+ * @param[in] len The length of the buffer.
+ */
+void LoggerWrite(const uint8_t* p, size_t len);
+
 /**
  * @brief   Register application-specific functions for logging and information retrieval.
  *
@@ -102,6 +349,230 @@ void LoggerPrintf(const uint8_t* p, uint8_t len);
  */
 void LoggerRegisterAppFunctions(GetMillisecondsFunction pGetMilliseconds, LoggerPrintfFunction pLoggerPrintf);
 
+/**
+ * @brief   Register an output function that takes logs of any length.
+ *
+ * @details When it is registered, it is used instead of the LoggerPrintf function, in every mode. Pass NULL to
+ *          go back to the LoggerPrintf function.
+ *
+ * @param[in] pLoggerWrite   A function pointer to print a log message of any length.
+ */
+void LoggerRegisterWriteFunction(LoggerWriteFunction pLoggerWrite);
+
+/**
+ * @brief   Register the emergency output of the FATAL logs.
+ *
+ * @details When it is registered, a FATAL log does not go through the log ring, the asynchronous buffers, the
+ *          batch, the sinks or the output lock. The logs still pending in the log ring, the asynchronous buffers
+ *          and the batch are written to the panic function first, oldest first, then the FATAL log itself, before
+ *          LOG() returns. The function must write the bytes synchronously, e.g. by polling the UART status
+ *          register, with interrupts disabled. Nothing is allocated or locked on this path, so it can be used
+ *          from a fault handler right before a reset; the log ring must not be flushed by another context at the
+ *          same time. Pass NULL to print the FATAL logs like the other logs.
+ *
+ * @param[in] pPanic   A function pointer to write bytes synchronously.
+ */
+void LoggerRegisterPanicFunction(LoggerWriteFunction pPanic);
+
+/**
+ * @brief   Register a vectored output function.
+ *
+ * @details When a vectored output function is registered, LOG() passes the pieces of every log to
+ *          it as segments instead of copying them into the logger buffer and calling the LoggerPrintf
+ *          function. Ring, deferred, tokenized and asynchronous modes print complete buffers and keep
+ *          using the LoggerPrintf function. Pass NULL to go back to the LoggerPrintf function.
+ *
+ * @param[in] pLoggerWritev   A function pointer to print a log message made of segments.
+ */
+void LoggerRegisterWritevFunction(LoggerWritevFunction pLoggerWritev);
+
+/**
+ * @brief Maximum number of sinks registered with LoggerAddSink().
+ *
+ * @details It can be set from the build, e.g. -DLOGGER_SINK_COUNT=2.
+ */
+#ifndef LOGGER_SINK_COUNT
+#define LOGGER_SINK_COUNT                                                           4
+#endif
+
+/**
+ * @brief   Register an additional output of the logs.
+ *
+ * @details Every log is formatted once and passed to the LoggerPrintf function and to every sink whose level it
+ *          reaches, e.g. to send warnings to a flash log and everything to SWO. Sinks registered without color
+ *          receive the logs without the color codes. Logs that no output wants are not formatted at all. The sinks
+ *          are called synchronously, also in asynchronous mode. While sinks are registered, the vectored output
+ *          function is not used and the LoggerPrintf function receives the complete logs instead.
+ *
+ * @param[in] pPrint   A function pointer to print a log.
+ * @param[in] level    The lowest log level printed by the sink.
+ * @param[in] color    true to keep the color codes of the logs, false to remove them.
+ *
+ * @return  The id of the sink, or -1 if LOGGER_SINK_COUNT sinks are registered already.
+ */
+int LoggerAddSink(LoggerPrintfFunction pPrint, logger_levels_t level, bool color);
+
+/**
+ * @brief   Change the lowest log level printed by a sink.
+ *
+ * @param[in] sink    The id returned by LoggerAddSink().
+ * @param[in] level   The lowest log level printed by the sink.
+ */
+void LoggerSetSinkLevel(int sink, logger_levels_t level);
+
+/**
+ * @brief   Unregister a sink.
+ *
+ * @param[in] sink   The id returned by LoggerAddSink().
+ */
+void LoggerRemoveSink(int sink);
+
+#if defined(LOGGER_FLASH)
+
+/**
+ * @brief Function pointer type to erase a flash sector, so that all its bytes read 0xFF.
+ *
+ * @details The function returns false if the sector could not be erased.
+ */
+typedef bool (*LoggerFlashEraseFunction)(uint32_t address);
+
+/**
+ * @brief Function pointer type to program one flash page, or to read data from the flash.
+ *
+ * @details The function returns false if the flash could not be accessed. Programming is only requested on
+ *          erased pages, a whole page at a time.
+ */
+typedef bool (*LoggerFlashProgramFunction)(uint32_t address, const uint8_t* data, uint32_t len);
+typedef bool (*LoggerFlashReadFunction)(uint32_t address, uint8_t* data, uint32_t len);
+
+/**
+ * @brief Geometry and access functions of the flash area of the log store.
+ */
+typedef struct
+{
+    uint32_t address;                                                                   /**< Address of the first sector */
+    uint32_t sector_size;                                                               /**< Erase size, a multiple of page_size of at least 512 bytes */
+    uint16_t sector_count;                                                              /**< Number of sectors, at least 2 */
+    uint16_t page_size;                                                                 /**< Program size, from 16 to LOGGER_FLASH_PAGE_SIZE bytes */
+    LoggerFlashEraseFunction erase;                                                     /**< Erase a sector */
+    LoggerFlashProgramFunction program;                                                 /**< Program a page */
+    LoggerFlashReadFunction read;                                                       /**< Read data */
+}logger_flash_t;
+
+/**
+ * @brief Position of a reader of the log store, see LoggerFlashNext().
+ */
+typedef struct
+{
+    uint16_t sector;                                                                    /**< Sector being read */
+    uint16_t remaining;                                                                 /**< Sectors left after it */
+    uint32_t offset;                                                                    /**< Offset of the next record in the sector, 0 before its header */
+}logger_flash_iterator_t;
+
+/**
+ * @brief   Mount the flash log store and register its sink.
+ *
+ * @details The sector headers are read to find the newest sector, and the first erased page of that sector is
+ *          found by a binary search, so the boot-time scan reads about sector_count + log2(pages per sector)
+ *          times. The new logs are appended after the existing ones, from the next page. Each log is a record of
+ *          the store, without its color codes; logs longer than 255 bytes are split into several records.
+ *
+ *          The store writes from its sink, so the LOG() that fills a page waits for the program of that page, and
+ *          the LOG() that starts a new sector also waits for the erase of that sector, which takes up to the
+ *          maximum sector erase time of the datasheet, often tens of milliseconds to seconds. A page that cannot
+ *          be programmed loses its logs and closes its sector. A sector that cannot be erased is skipped, so a
+ *          single LOG() makes at most sector_count erase attempts, and the store stops when none can be erased.
+ *          The failures are counted, see LoggerFlashErrors().
+ *
+ * @param[in] flash   The flash area, which must stay valid while the store is used.
+ * @param[in] level   The lowest log level stored.
+ *
+ * @return  false if the geometry is invalid or no sink could be registered, true otherwise.
+ */
+bool LoggerFlashInit(const logger_flash_t *flash, logger_levels_t level);
+
+/**
+ * @brief   Program the page being filled, even if it is not full.
+ *
+ * @details The logs are only programmed when a page is full. Call this function before a reset or before reading
+ *          the store to keep the latest logs. The rest of the page stays unused, so calling it after every log
+ *          wastes flash and wears it out faster.
+ */
+void LoggerFlashSync(void);
+
+/**
+ * @brief   Get the number of failed erases and programs of the flash since LoggerFlashInit().
+ *
+ * @return  The number of failures.
+ */
+uint32_t LoggerFlashErrors(void);
+
+/**
+ * @brief   Start reading the log store from its oldest record.
+ *
+ * @param[out] iterator   The reader position.
+ */
+void LoggerFlashIterate(logger_flash_iterator_t *iterator);
+
+/**
+ * @brief   Read the next record of the log store.
+ *
+ * @details Records still in the page being filled are not read, see LoggerFlashSync(). Records longer than the
+ *          buffer are truncated.
+ *
+ * @param[in,out] iterator   The reader position, started by LoggerFlashIterate().
+ * @param[out]    buffer     The buffer that receives the record.
+ * @param[in]     size       The size of the buffer.
+ *
+ * @return  The length of the record copied into the buffer, or 0 after the newest record.
+ */
+uint16_t LoggerFlashNext(logger_flash_iterator_t *iterator, uint8_t *buffer, uint16_t size);
+
+#endif
+
+/**
+ * @brief   Register an integer tick source for the timestamps of the logs.
+ *
+ * @details When a tick source is registered, it is used instead of the GetMilliseconds function and
+ *          the timestamps are formatted with integer arithmetic only, so neither float arithmetic
+ *          nor float printf support is needed. Pass NULL to go back to the GetMilliseconds function.
+ *
+ * @param[in] pGetTicks        A function pointer to obtain the tick count.
+ * @param[in] ticksPerSecond   The number of ticks in one second, e.g. 1000000 for a microsecond counter or 32768
+ *                             for a watch crystal. It is ignored with NULL.
+ *
+ * @return  true on success, false if the rate is 0, in which case the previous tick source is kept.
+ */
+bool LoggerRegisterTicksFunction(GetTicksFunction pGetTicks, uint32_t ticksPerSecond);
+
+#if defined(LOGGER_THREAD_SAFE)
+
+/**
+ * @brief   Register the functions of thread-safe mode.
+ *
+ * @details The lock functions are called around every handoff of a complete log to the output, so that logs of
+ *          different contexts are not interleaved. They can be left NULL when the output is safe by itself, e.g.
+ *          with LOGGER_RING.
+ *
+ * @param[in] pGetContext   A function pointer to obtain the index of the calling context, e.g. the core number.
+ *                          It is not used with LOGGER_THREAD_LOCAL.
+ * @param[in] pLock         A function pointer to take the output lock, or NULL.
+ * @param[in] pUnlock       A function pointer to release the output lock, or NULL.
+ */
+void LoggerRegisterThreadFunctions(GetContextFunction pGetContext, LoggerLockFunction pLock, LoggerLockFunction pUnlock);
+
+#endif
+
+/**
+ * @brief   Get the elapsed time in microseconds.
+ *
+ * @details This function converts the registered tick source into microseconds. If no tick source is
+ *          registered, it converts the value of GetMilliseconds() instead.
+ *
+ * @return  The elapsed time in microseconds, or LOGGER_TIMESTAMP_INVALID if no time source is registered.
+ */
+uint64_t GetMicroseconds(void);
+
 /**
  * @brief   Get the application name.
  *
@@ -121,10 +592,43 @@ const char* GetAppName(void);
  *          it does not exceed the maximum size defined by `sizeof(app_name) - 1`.
  *          The function null-terminates the array to ensure proper string termination.
  *
+ * @note    The log prefixes are rebuilt without locking, so call it before several contexts log.
+ *
  * @param[in] appName   A pointer to the string representing the new application name.
  */
 void SetAppName(const char* appName);
 
+/**
+ * @brief Output profiles of the text logs, selected at runtime with SetLogProfile().
+ */
+typedef enum
+{
+    LOGGER_PROFILE_FULL,                                                                /**< Color, application name, timestamp, level, file, function and line */
+    LOGGER_PROFILE_NO_COLOR,                                                            /**< The full log syntax without ANSI escapes */
+    LOGGER_PROFILE_COMPACT,                                                             /**< "[timestamp]L file:line message", L being the level initial */
+    LOGGER_PROFILE_BARE,                                                                /**< The message only */
+}logger_profile_t;
+
+/**
+ * @brief   Get the output profile of the text logs.
+ *
+ * @return  The current output profile.
+ */
+logger_profile_t GetLogProfile(void);
+
+/**
+ * @brief   Set the output profile of the text logs.
+ *
+ * @details LOG() renders only the parts of the log syntax that the profile needs, so the bytes per log shrink with
+ *          it, e.g. on links where nothing renders ANSI escapes. In deferred mode it applies to the logs formatted
+ *          by the next LoggerFlush(). Tokenized frames are not affected, the decoder renders them.
+ *
+ * @note    The log prefixes are rebuilt without locking, so call it before several contexts log.
+ *
+ * @param[in] profile   The new output profile.
+ */
+void SetLogProfile(logger_profile_t profile);
+
 /**
  * @brief   Get the current log level.
  *
@@ -140,31 +644,532 @@ logger_levels_t GetCurrentLogLevel(void);
  * @brief   Set the current log level.
  *
  * @details This function sets the current log level to the specified value `level`
- *          in the global variable `currentLogLevel`.
+ *          in the global variable `currentLogLevel`. The level of every module tag
+ *          is set to the same value, see SetTagLogLevel().
  *
  * @param[in] level   The new log level to be set, typically of the type logger_levels_t.
  */
 void SetCurrentLogLevel(logger_levels_t level);
 
+/**
+ * @brief   Get the global sampling rate of LOGGER_SAMPLED().
+ *
+ * @return  The global sampling rate.
+ */
+uint32_t GetLogSamplingRate(void);
+
+/**
+ * @brief   Set the global sampling rate of LOGGER_SAMPLED().
+ *
+ * @details The period of every sampled call site is multiplied by this rate: at 1, the default, LOGGER_SAMPLED(
+ *          level, 100, ...) prints one call in 100, at 10 one call in 1000. At 0 no sampled log is printed.
+ *
+ * @param[in] rate   The new global sampling rate.
+ */
+void SetLogSamplingRate(uint32_t rate);
+
+/**
+ * @brief Number of module tags that can be passed to LOGGER_TAG().
+ *
+ * @details Tags are numbered from 0 to LOGGER_TAG_COUNT - 1 by the application, e.g. with an enum. It can be set
+ *          from the build, e.g. -DLOGGER_TAG_COUNT=16.
+ */
+#ifndef LOGGER_TAG_COUNT
+#define LOGGER_TAG_COUNT                                                            8
+#endif
+
+/**
+ * @brief Log level that the current log level and the levels of the module tags start with.
+ */
+#define LOGGER_DEFAULT_LEVEL                                                        WARN
+
+/**
+ * @brief   Get the log level of a module tag.
+ *
+ * @param[in] tag   The module tag, below LOGGER_TAG_COUNT.
+ *
+ * @return  The log level of the tag, or the current log level if the tag is out of range.
+ */
+logger_levels_t GetTagLogLevel(uint8_t tag);
+
+/**
+ * @brief   Set the log level of a module tag.
+ *
+ * @details Logs of the tag passed to LOGGER_TAG() are printed from this level on, independently of the current
+ *          log level, e.g. to enable DBG for one driver. The next SetCurrentLogLevel() overrides it.
+ *
+ * @param[in] tag     The module tag, below LOGGER_TAG_COUNT. Other values are ignored.
+ * @param[in] level   The new log level of the tag.
+ */
+void SetTagLogLevel(uint8_t tag, logger_levels_t level);
+
+/**
+ * @brief Current log level for the application.
+ *
+ * @details It is exposed so that LOGGER() can filter logs at the call site. Use SetCurrentLogLevel() to change it.
+ */
+extern logger_levels_t currentLogLevel;
+
+/**
+ * @brief   Check if a log level passes the current log level.
+ *
+ * @details This inline check costs one load and one comparison, so filtered-out logs never enter LOG().
+ *
+ * @param[in] level   The log level to check.
+ *
+ * @return  true if logs of this level are printed, false otherwise.
+ */
+static inline bool LoggerIsLevelEnabled(int level) {
+    return level >= (int) currentLogLevel;
+}
+
+/**
+ * @brief Log levels of the module tags.
+ *
+ * @details The levels are stored relative to LOGGER_DEFAULT_LEVEL, so that the zero-initialized table starts at the
+ *          default level. It is exposed so that LOGGER_TAG() can filter logs at the call site. Use SetTagLogLevel()
+ *          to change it.
+ */
+extern int8_t tagLogLevels[LOGGER_TAG_COUNT];
+
+/**
+ * @brief   Check if a log level passes the log level of a module tag.
+ *
+ * @details Like LoggerIsLevelEnabled(), this inline check costs one load from the tag table and one comparison.
+ *          A tag out of range is checked against the current log level, like GetTagLogLevel() reports it.
+ *
+ * @param[in] tag     The module tag, below LOGGER_TAG_COUNT.
+ * @param[in] level   The log level to check.
+ *
+ * @return  true if logs of this tag and level are printed, false otherwise.
+ */
+static inline bool LoggerIsTagLevelEnabled(uint8_t tag, int level) {
+    if (tag >= LOGGER_TAG_COUNT) {
+        return LoggerIsLevelEnabled(level);
+    }
+    return level >= (int) LOGGER_DEFAULT_LEVEL + tagLogLevels[tag];
+}
+
+/**
+ * @brief Global sampling rate of LOGGER_SAMPLED().
+ *
+ * @details It is exposed so that LOGGER_SAMPLED() can sample logs at the call site. Use SetLogSamplingRate() to
+ *          change it.
+ */
+extern uint32_t logSamplingRate;
+
+/**
+ * @brief   Check if a sampled call site prints this call.
+ *
+ * @details The counter of the call site counts the calls of one period, and the first call of every period is
+ *          printed. The check costs a multiplication, an increment and a store, so skipped calls never enter
+ *          LOG(). A period past UINT32_MAX is cut to UINT32_MAX rather than wrapped. The counter is not protected
+ *          against concurrent callers, which can only shift the sampling.
+ *
+ * @param[in,out] count    The counter of the call site.
+ * @param[in]     one_in   The period of the call site, multiplied by the global sampling rate.
+ *
+ * @return  true if this call is printed, false if it is skipped.
+ */
+static inline bool LoggerSample(uint32_t *count, uint32_t one_in) {
+    // The division folds away for the constant period of a call site.
+    uint32_t period = (one_in != 0 && logSamplingRate > UINT32_MAX / one_in) ? UINT32_MAX : one_in * logSamplingRate;
+    uint32_t calls = *count;
+
+    if (logSamplingRate == 0) {
+        return false;
+    }
+    *count = (calls + 1 >= period) ? 0 : calls + 1;
+    return calls == 0;
+}
+
+/**
+ * @brief State of a rate-limited call site, see LOGGER_RATELIMIT().
+ */
+typedef struct
+{
+    uint64_t window;                                                                    /**< Start of the current second in microseconds */
+    uint32_t count;                                                                     /**< Logs printed in the current second */
+    uint32_t suppressed;                                                                /**< Logs dropped since the last summary */
+    bool started;                                                                       /**< Whether the first window has started */
+}logger_ratelimit_t;
+
+/**
+ * @brief   Check if a rate-limited call site may print a log.
+ *
+ * @details Up to per_second logs are let through in each one-second window of GetMicroseconds(). The excess logs
+ *          are counted, and their number is returned once with the first log of a later window so that the call
+ *          site can print a summary. A per_second of 0 drops every log and only counts them. Nothing is limited
+ *          when no time source is registered.
+ *
+ * @param[in,out] limit        The state of the call site.
+ * @param[in]     per_second   The number of logs allowed per second.
+ * @param[out]    suppressed   The number of logs to report as suppressed before this one, usually 0.
+ *
+ * @return  true if the log may be printed, false if it must be dropped.
+ */
+bool LoggerRateLimit(logger_ratelimit_t *limit, uint32_t per_second, uint32_t *suppressed);
+
+/**
+ * @brief Logger statistics.
+ *
+ * @details When LOGGER_STATS is defined, the logger counts the logs emitted and filtered per level, the bytes sent,
+ *          the truncated messages and the dropped logs, and measures the duration of LOG() and of the output calls.
+ *          The counters are read with LoggerGetStats().
+ */
+#if defined(LOGGER_STATS)
+
+/**
+ * @brief Counters of the logger (LOGGER_STATS).
+ *
+ * @details The durations are in ticks of the function registered with LoggerRegisterTicksFunction(), e.g. CPU
+ *          cycles when it reads the DWT cycle counter, and stay 0 without it. The counters are not atomic, so the
+ *          logs of contexts that preempt each other may be missed.
+ */
+typedef struct
+{
+    uint32_t emitted[FATAL + 1];                                                        /**< Logs sent to the outputs, per level */
+    uint32_t filtered[FATAL + 1];                                                       /**< Logs below the log level, per level */
+    uint64_t bytes;                                                                     /**< Bytes sent to the outputs */
+    uint32_t truncated;                                                                 /**< Messages cut at the end of the logger buffer */
+    uint32_t dropped;                                                                   /**< Logs dropped because a queue was full */
+    uint32_t log_calls;                                                                 /**< Calls of LOG() that were measured */
+    uint64_t log_ticks;                                                                 /**< Total duration of these calls */
+    uint32_t log_max_ticks;                                                             /**< Longest call of LOG() */
+    uint32_t output_max_ticks;                                                          /**< Longest call of the output function or of a sink */
+}logger_stats_t;
+
+/**
+ * @brief   Count a log below the log level, called by the logging macros.
+ *
+ * @param[in] level   Log level.
+ */
+void LoggerStatsFiltered(int level);
+
+/**
+ * @brief   Copy the counters of the logger. The average duration of LOG() is log_ticks / log_calls.
+ *
+ * @param[out] stats   The counters.
+ */
+void LoggerGetStats(logger_stats_t *stats);
+
+/**
+ * @brief   Reset the counters of the logger.
+ */
+void LoggerResetStats(void);
+
+/**
+ * @brief Count of a log below the log level in the logging macros, nothing without LOGGER_STATS.
+ */
+#define LOGGER_STATS_FILTERED(level)                                                LoggerStatsFiltered(level)
+#else
+#define LOGGER_STATS_FILTERED(level)                                                (void) 0
+#endif
+
 /**
  * @brief   Retrieve the current content of the logger buffer.
  *
  * @details This function copies the current content of the logger buffer into
  *          the provided buffer. The logger buffer stores formatted log messages
- *          and related information.
+ *          and related information. In hard fault mode (HARD_FAULT_LOGGER_ENABLED)
+ *          it holds the trail as logger_breadcrumb_t entries, oldest first.
  *
  * @param[out] buffer   A pointer to the buffer where the logger content will be copied.
  */
 void GetLoggerBuffer(char *buffer);
 
-#if defined(LOGGER_ENABLED)
+/**
+ * @brief   Print the pending logs.
+ *
+ * @details In ring mode (LOGGER_RING) this function prints every log that has been committed to the log ring
+ *          since the last call, and in deferred mode (LOGGER_DEFERRED) it also formats them. It is meant to be
+ *          called from a single background task, away from the code that produces the logs. In batched mode
+ *          (LOGGER_BATCH) it prints the batch. In the other modes logs are printed immediately and this function
+ *          does nothing.
+ */
+void LoggerFlush(void);
+
+/**
+ * @brief   Signal the end of an asynchronous transmission.
+ *
+ * @details In asynchronous mode (LOGGER_ASYNC) this function must be called, typically from the DMA or UART
+ *          interrupt, when the buffer passed to the LoggerPrintf function has been transmitted. It frees that
+ *          buffer and starts the transmission of the next one. In the other modes it does nothing.
+ */
+void LoggerTxComplete(void);
+
+/**
+ * @brief   Extracts the file name from a given file path.
+ *
+ * @details This function takes a file path as input and identifies the last occurrence
+ *          of '/' or '\\' to determine the file name. It returns a pointer to the substring
+ *          containing the file name.
+ *
+ * @param[in] path A pointer to the file path string.
+ *
+ * @return  A pointer to the substring containing the file name, or the original path if
+ *          no separator ('/' or '\\') is found.
+ */
+const char* GetFileNameFromPath(const char* path);
+
+/**
+ * @brief Source file name passed by LOGGER().
+ *
+ * @details Compilers that provide __FILE_NAME__ (GCC 12, Clang 9 and later) give the file name without its
+ *          directories at compile time, so only the file names are stored in flash and LOG() does not search the
+ *          path. Otherwise LOGGER() falls back to __FILE__ and LOGGER_FILE_NAME() strips the directories once per
+ *          call site; the build can also shorten the stored paths with -fmacro-prefix-map=<source dir>/=.
+ *
+ * @param name   The variable that receives the file name of the call site.
+ */
+#if defined(__FILE_NAME__)
+#define LOGGER_FILE                                                                 __FILE_NAME__
+#define LOGGER_FILE_NAME(name)                                                      const char *const name = __FILE_NAME__
+#else
+#define LOGGER_FILE                                                                 __FILE__
+#define LOGGER_FILE_NAME(name)                                                                      \
+    static const char *name = NULL;                                                                 \
+    if (name == NULL) {                                                                             \
+        name = GetFileNameFromPath(__FILE__);                                                       \
+    }
+#endif
+
+#if defined(LOGGER_ISR_ENABLED)
+
+/**
+ * @brief Number of records of the interrupt log ring, a power of two of at least 2. It can be set from the build.
+ */
+#ifndef LOGGER_ISR_LENGTH
+#define LOGGER_ISR_LENGTH                                                           16
+#endif
+
+/**
+ * @brief Maximum number of integer arguments of LOGGER_ISR().
+ */
+#define LOGGER_ISR_MAX_ARGS                                                         4
+
+/**
+ * @brief Call site of LOGGER_ISR(), a static of the call site whose address identifies it in the records.
+ */
+typedef struct
+{
+    const char *fmt;                                                                    /**< Format string with integer conversions only */
+    const char *file;                                                                   /**< Source file */
+    const char *function;                                                               /**< Function */
+    int line;                                                                           /**< Line */
+    int level;                                                                          /**< Log level */
+}logger_isr_site_t;
+
+/**
+ * @brief   Record a log from an interrupt handler.
+ *
+ * @details The call site, the tick count and the arguments are copied into a fixed-size record of a lock-free ring,
+ *          without formatting, C library calls or callbacks other than the time source. The only loop is the
+ *          reservation of the record, which is retried only when a log of a preempting context took the record
+ *          in between, so the time is bounded by the interrupt nesting depth. The records are formatted and
+ *          printed by LoggerFlush(). Records that do not fit into the ring are dropped and counted.
+ *
+ * @param[in] site    The call site.
+ * @param[in] args    The arguments.
+ * @param[in] count   The number of arguments, at most LOGGER_ISR_MAX_ARGS.
+ */
+void LoggerIsr(const logger_isr_site_t *site, const uint32_t *args, uint8_t count);
+
+/**
+ * @brief Helpers of LOGGER_ISR(): the format string and the arguments that follow it.
+ */
+#define LOGGER_ISR_FORMAT(fmt, ...)                                                 fmt
+#define LOGGER_ISR_ARGS(fmt, ...)                                                   __VA_ARGS__
+
+/**
+ * @brief Compile-time check of the format string of LOGGER_ISR() against the arguments as LoggerFlush() passes
+ *        them, i.e. as unsigned int. The call is never executed.
+ */
+#define LOGGER_ISR_CHECK(...)                                                       LOGGER_KV_CONCAT(LOGGER_ISR_CHECK_, LOGGER_KV_COUNT(__VA_ARGS__))(__VA_ARGS__)
+#define LOGGER_ISR_CHECK_1(fmt)                                                     snprintf(NULL, 0, fmt)
+#define LOGGER_ISR_CHECK_2(fmt, a)                                                  snprintf(NULL, 0, fmt, (unsigned int)(a))
+#define LOGGER_ISR_CHECK_3(fmt, a, b)                                               snprintf(NULL, 0, fmt, (unsigned int)(a), (unsigned int)(b))
+#define LOGGER_ISR_CHECK_4(fmt, a, b, c)                                            snprintf(NULL, 0, fmt, (unsigned int)(a), (unsigned int)(b), (unsigned int)(c))
+#define LOGGER_ISR_CHECK_5(fmt, a, b, c, d)                                         snprintf(NULL, 0, fmt, (unsigned int)(a), (unsigned int)(b), (unsigned int)(c), (unsigned int)(d))
+
+/**
+ * @brief Macro for logging from interrupt handlers with up to LOGGER_ISR_MAX_ARGS integer arguments.
+ *
+ * @details The log is recorded in bounded time and formatted by the next LoggerFlush(), see LoggerIsr(). The
+ *          arguments are converted to uint32_t, so the format string may only use integer conversions of int size,
+ *          such as %d, %u, %x and %c. In tokenized mode the token is calculated by LoggerFlush() from the file and
+ *          the line, like the token of LOGGER().
+ *
+ * @param level Log level to be used for the message (e.g., DBG, INFO, WARN, ERR, FATAL).
+ * @param ...   The format string, a string literal, followed by the integer arguments.
+ */
+#define LOGGER_ISR(level, ...)                                                                      \
+    do {                                                                                            \
+        if ((level) >= LOGGER_MIN_LEVEL && LoggerIsLevelEnabled(level)) {                           \
+            static const logger_isr_site_t logger_site = {                                          \
+                LOGGER_ISR_FORMAT(__VA_ARGS__, 0), LOGGER_FILE, __func__, __LINE__, level};         \
+            const uint32_t logger_args[] = {LOGGER_ISR_ARGS(__VA_ARGS__, 0)};                       \
+            _Static_assert(LOGGER_KV_COUNT(__VA_ARGS__) - 1 <= LOGGER_ISR_MAX_ARGS,                 \
+                    "LOGGER_ISR() takes at most LOGGER_ISR_MAX_ARGS arguments");                    \
+            if (0) {                                                                                \
+                (void) LOGGER_ISR_CHECK(__VA_ARGS__);                                               \
+            }                                                                                       \
+            LoggerIsr(&logger_site, logger_args, (uint8_t)(LOGGER_KV_COUNT(__VA_ARGS__) - 1));      \
+        } else if ((level) >= LOGGER_MIN_LEVEL) {                                                   \
+            LOGGER_STATS_FILTERED(level);                                                           \
+        }                                                                                           \
+    } while (0)
+
+#elif defined(LOGGER_ENABLED)
+
+/**
+ * @brief Without LOGGER_ISR_ENABLED this macro works like LOGGER(), which may only be called from interrupts in
+ *        ring mode.
+ */
+#define LOGGER_ISR(level, ...)                                                      LOGGER(level, __VA_ARGS__)
+
+#endif
+
+#if defined(LOGGER_TOKENIZED)
+
+/**
+ * @brief This function sends a log as a compact tokenized frame instead of text. The host-side decoder rebuilds
+ *        the text from the token of the call site.
+ *
+ * @param level         Log level
+ * @param token         The cached token of the call site, calculated on the first call when it is zero.
+ * @param file          The name of the file in which the file is used.
+ * @param line          The name of the file in which the line is used.
+ * @param fmt           The string to be printed.
+ * @param ...           The argument to be printed.
+ *
+ */
+void LOG_TOKENIZED(int level, uint32_t *token, const char *file, int line, const char *fmt, ...);
+
+/**
+ * @brief Macro for tokenized logging with log level, file and line information.
+ *
+ * @details Every call site keeps its own token, so the token is calculated only once.
+ *
+ * @param level Log level to be used for the message (e.g., DBG, INFO, WARN, ERR, FATAL).
+ * @param ...   Variable arguments to be formatted and included in the log message. The format string must be a
+ *              string literal so that the decoder can find it in the sources.
+ */
+#define LOGGER(level, ...)                                                                          \
+    do {                                                                                            \
+        if ((level) >= LOGGER_MIN_LEVEL && LoggerIsLevelEnabled(level)) {                           \
+            static uint32_t logger_token = 0;                                                       \
+            LOG_TOKENIZED(level, &logger_token, LOGGER_FILE, __LINE__, __VA_ARGS__);                \
+        } else if ((level) >= LOGGER_MIN_LEVEL) {                                                   \
+            LOGGER_STATS_FILTERED(level);                                                           \
+        }                                                                                           \
+    } while (0)
+
+/**
+ * @brief Macro for tokenized logging of a module, filtered by the log level of its tag.
+ *
+ * @param tag   Module tag, below LOGGER_TAG_COUNT.
+ * @param level Log level to be used for the message (e.g., DBG, INFO, WARN, ERR, FATAL).
+ * @param ...   Variable arguments to be formatted and included in the log message.
+ */
+#define LOGGER_TAG(tag, level, ...)                                                                 \
+    do {                                                                                            \
+        if ((level) >= LOGGER_MIN_LEVEL && LoggerIsTagLevelEnabled(tag, level)) {                   \
+            static uint32_t logger_token = 0;                                                       \
+            LOG_TOKENIZED(level, &logger_token, LOGGER_FILE, __LINE__, __VA_ARGS__);                \
+        } else if ((level) >= LOGGER_MIN_LEVEL) {                                                   \
+            LOGGER_STATS_FILTERED(level);                                                           \
+        }                                                                                           \
+    } while (0)
+
+/**
+ * @brief Macro for tokenized logging limited to a number of logs per second.
+ *
+ * @details The summary of the suppressed logs is sent with the token of the negated line number, which the decoder
+ *          knows for every LOGGER_RATELIMIT() call site. The summary only appears when a later log of the same call
+ *          site is let through.
+ *
+ * @param level        Log level to be used for the message (e.g., DBG, INFO, WARN, ERR, FATAL).
+ * @param per_second   Number of logs allowed per second.
+ * @param ...          Variable arguments to be formatted and included in the log message.
+ */
+#define LOGGER_RATELIMIT(level, per_second, ...)                                                    \
+    do {                                                                                            \
+        if ((level) >= LOGGER_MIN_LEVEL && LoggerIsLevelEnabled(level)) {                           \
+            static logger_ratelimit_t logger_limit;                                                 \
+            static uint32_t logger_token = 0;                                                       \
+            static uint32_t logger_summary_token = 0;                                               \
+            uint32_t logger_suppressed;                                                             \
+            if (LoggerRateLimit(&logger_limit, per_second, &logger_suppressed)) {                   \
+                if (logger_suppressed != 0) {                                                       \
+                    LOG_TOKENIZED(level, &logger_summary_token, LOGGER_FILE, -__LINE__,             \
+                            "%lu logs suppressed", (unsigned long) logger_suppressed);              \
+                }                                                                                   \
+                LOG_TOKENIZED(level, &logger_token, LOGGER_FILE, __LINE__, __VA_ARGS__);            \
+            }                                                                                       \
+        } else if ((level) >= LOGGER_MIN_LEVEL) {                                                   \
+            LOGGER_STATS_FILTERED(level);                                                           \
+        }                                                                                           \
+    } while (0)
+
+/**
+ * @brief Macro for tokenized logging of one call in one_in at this call site, for logs in high-frequency loops.
+ *
+ * @param level    Log level to be used for the message (e.g., DBG, INFO, WARN, ERR, FATAL).
+ * @param one_in   Period of the call site, see LoggerSample().
+ * @param ...      Variable arguments to be formatted and included in the log message.
+ */
+#define LOGGER_SAMPLED(level, one_in, ...)                                                          \
+    do {                                                                                            \
+        if ((level) >= LOGGER_MIN_LEVEL && LoggerIsLevelEnabled(level)) {                           \
+            static uint32_t logger_count = 0;                                                       \
+            if (LoggerSample(&logger_count, one_in)) {                                              \
+                static uint32_t logger_token = 0;                                                   \
+                LOG_TOKENIZED(level, &logger_token, LOGGER_FILE, __LINE__, __VA_ARGS__);            \
+            }                                                                                       \
+        } else if ((level) >= LOGGER_MIN_LEVEL) {                                                   \
+            LOGGER_STATS_FILTERED(level);                                                           \
+        }                                                                                           \
+    } while (0)
+
+/**
+ * @brief This function sends a hex dump as tokenized frames of raw bytes, rendered by the host-side decoder.
+ *
+ * @param level         Log level
+ * @param token         The cached token of the call site, calculated on the first call when it is zero.
+ * @param file          The name of the file in which the file is used.
+ * @param line          The name of the file in which the line is used.
+ * @param data          The bytes to be dumped.
+ * @param len           The number of bytes.
+ *
+ */
+void LOG_HEXDUMP_TOKENIZED(int level, uint32_t *token, const char *file, int line, const void *data, size_t len);
+
+/**
+ * @brief Macro for a tokenized hex dump of a buffer.
+ *
+ * @param level Log level to be used for the dump (e.g., DBG, INFO, WARN, ERR, FATAL).
+ * @param data  A pointer to the bytes to be dumped.
+ * @param len   The number of bytes.
+ */
+#define LOGGER_HEXDUMP(level, data, len)                                                            \
+    do {                                                                                            \
+        if ((level) >= LOGGER_MIN_LEVEL && LoggerIsLevelEnabled(level)) {                           \
+            static uint32_t logger_token = 0;                                                       \
+            LOG_HEXDUMP_TOKENIZED(level, &logger_token, LOGGER_FILE, __LINE__, data, len);          \
+        } else if ((level) >= LOGGER_MIN_LEVEL) {                                                   \
+            LOGGER_STATS_FILTERED(level);                                                           \
+        }                                                                                           \
+    } while (0)
+
+#elif defined(LOGGER_ENABLED)
 
 /**
  * @brief This function prints the string to be printed and the argument with the information of the place where it
  *        was printed.
  *
  * @param level         Log level
- * @param file          The name of the file in which the file is used.
+ * @param file          The name of the file in which the file is used, without its directories.
  * @param function      The name of the file in which the function is used.
  * @param line          The name of the file in which the line is used.
  * @param fmt           The string to be printed.
@@ -178,16 +1183,127 @@ void LOG(int level, const char *file, const char *function, int line, const char
  *
  * @details This macro provides a convenient way to log messages with specified log levels.
  *          It uses the underlying LOG macro, passing the provided log level along with
- *          the current file name (__FILE__), function name (__FUNCTION__), and line number
+ *          the current file name (LOGGER_FILE_NAME()), function name (__FUNCTION__), and line number
  *          (__LINE__) information. Additional formatting and variable arguments are also supported.
  *
  * @param level Log level to be used for the message (e.g., DBG, INFO, WARN, ERR, FATAL).
  * @param ...   Variable arguments to be formatted and included in the log message.
  *
  * @note This macro internally calls the LOG macro and passes the relevant information.
- *       The format and usage are similar to the LOG macro.
+ *       The format and usage are similar to the LOG macro. Calls below LOGGER_MIN_LEVEL compile to nothing,
+ *       and calls below the current log level return before LOG() is called.
+ */
+#define LOGGER(level, ...)                                                                          \
+    do {                                                                                            \
+        if ((level) >= LOGGER_MIN_LEVEL && LoggerIsLevelEnabled(level)) {                           \
+            LOGGER_FILE_NAME(logger_file);                                                          \
+            LOG(level, logger_file, __FUNCTION__, __LINE__, __VA_ARGS__);                           \
+        } else if ((level) >= LOGGER_MIN_LEVEL) {                                                   \
+            LOGGER_STATS_FILTERED(level);                                                           \
+        }                                                                                           \
+    } while (0)
+
+/**
+ * @brief Macro for logging of a module, filtered by the log level of its tag instead of the current log level.
+ *
+ * @param tag   Module tag, below LOGGER_TAG_COUNT.
+ * @param level Log level to be used for the message (e.g., DBG, INFO, WARN, ERR, FATAL).
+ * @param ...   Variable arguments to be formatted and included in the log message.
+ */
+#define LOGGER_TAG(tag, level, ...)                                                                 \
+    do {                                                                                            \
+        if ((level) >= LOGGER_MIN_LEVEL && LoggerIsTagLevelEnabled(tag, level)) {                   \
+            LOGGER_FILE_NAME(logger_file);                                                          \
+            LOG(level, logger_file, __FUNCTION__, __LINE__, __VA_ARGS__);                           \
+        } else if ((level) >= LOGGER_MIN_LEVEL) {                                                   \
+            LOGGER_STATS_FILTERED(level);                                                           \
+        }                                                                                           \
+    } while (0)
+
+/**
+ * @brief Macro for logging limited to a number of logs per second at this call site.
+ *
+ * @details The excess logs are dropped and counted in the static state of the call site. The first log let through
+ *          afterwards is preceded by a "N logs suppressed" summary from the same call site, so the summary only
+ *          appears when a later log of that call site is let through. The state is not protected against
+ *          concurrent callers, which can only make the count inexact.
+ *
+ * @param level        Log level to be used for the message (e.g., DBG, INFO, WARN, ERR, FATAL).
+ * @param per_second   Number of logs allowed per second.
+ * @param ...          Variable arguments to be formatted and included in the log message.
+ */
+#define LOGGER_RATELIMIT(level, per_second, ...)                                                    \
+    do {                                                                                            \
+        if ((level) >= LOGGER_MIN_LEVEL && LoggerIsLevelEnabled(level)) {                           \
+            static logger_ratelimit_t logger_limit;                                                 \
+            uint32_t logger_suppressed;                                                             \
+            if (LoggerRateLimit(&logger_limit, per_second, &logger_suppressed)) {                   \
+                LOGGER_FILE_NAME(logger_file);                                                      \
+                if (logger_suppressed != 0) {                                                       \
+                    LOG(level, logger_file, __FUNCTION__, __LINE__, "%lu logs suppressed",          \
+                            (unsigned long) logger_suppressed);                                     \
+                }                                                                                   \
+                LOG(level, logger_file, __FUNCTION__, __LINE__, __VA_ARGS__);                       \
+            }                                                                                       \
+        } else if ((level) >= LOGGER_MIN_LEVEL) {                                                   \
+            LOGGER_STATS_FILTERED(level);                                                           \
+        }                                                                                           \
+    } while (0)
+
+/**
+ * @brief Macro for logging of one call in one_in at this call site, for logs in high-frequency loops.
+ *
+ * @details Every call site keeps its own counter, and the skipped calls return before LOG() is called. The period
+ *          can be scaled at runtime for all sampled call sites with SetLogSamplingRate().
+ *
+ * @param level    Log level to be used for the message (e.g., DBG, INFO, WARN, ERR, FATAL).
+ * @param one_in   Period of the call site, see LoggerSample().
+ * @param ...      Variable arguments to be formatted and included in the log message.
+ */
+#define LOGGER_SAMPLED(level, one_in, ...)                                                          \
+    do {                                                                                            \
+        if ((level) >= LOGGER_MIN_LEVEL && LoggerIsLevelEnabled(level)) {                           \
+            static uint32_t logger_count = 0;                                                       \
+            if (LoggerSample(&logger_count, one_in)) {                                              \
+                LOGGER_FILE_NAME(logger_file);                                                      \
+                LOG(level, logger_file, __FUNCTION__, __LINE__, __VA_ARGS__);                       \
+            }                                                                                       \
+        } else if ((level) >= LOGGER_MIN_LEVEL) {                                                   \
+            LOGGER_STATS_FILTERED(level);                                                           \
+        }                                                                                           \
+    } while (0)
+
+/**
+ * @brief This function prints a hex dump of a buffer: one log with the default log syntax and the size of the
+ *        dump, then rows of up to 16 bytes with their offset, in hexadecimal and in ASCII. In ring and deferred
+ *        modes the rows are recorded in the log ring like any other log, the bytes themselves in deferred mode.
+ *
+ * @param level         Log level
+ * @param file          The name of the file in which the file is used.
+ * @param function      The name of the file in which the function is used.
+ * @param line          The name of the file in which the line is used.
+ * @param data          The bytes to be dumped.
+ * @param len           The number of bytes.
+ *
  */
-#define LOGGER(level, ...)  LOG(level, __FILE__, __FUNCTION__, __LINE__, __VA_ARGS__)
+void LOG_HEXDUMP(int level, const char *file, const char *function, int line, const void *data, size_t len);
+
+/**
+ * @brief Macro for a hex dump of a buffer, e.g. a packet, printed with a single header instead of one log per byte.
+ *
+ * @param level Log level to be used for the dump (e.g., DBG, INFO, WARN, ERR, FATAL).
+ * @param data  A pointer to the bytes to be dumped.
+ * @param len   The number of bytes.
+ */
+#define LOGGER_HEXDUMP(level, data, len)                                                            \
+    do {                                                                                            \
+        if ((level) >= LOGGER_MIN_LEVEL && LoggerIsLevelEnabled(level)) {                           \
+            LOGGER_FILE_NAME(logger_file);                                                          \
+            LOG_HEXDUMP(level, logger_file, __FUNCTION__, __LINE__, data, len);                     \
+        } else if ((level) >= LOGGER_MIN_LEVEL) {                                                   \
+            LOGGER_STATS_FILTERED(level);                                                           \
+        }                                                                                           \
+    } while (0)
 
 #elif defined(HARD_FAULT_LOGGER_ENABLED)
 
@@ -195,9 +1311,10 @@ void LOG(int level, const char *file, const char *function, int line, const char
  * @brief   Log a message with file and line information.
  *
  * @details This function logs a message with information about the source file
- *          and line number where the log occurred. It appends the file name,
- *          line number, and a separator to the logger buffer. The stored logs
- *          in the buffer are managed to prevent overflow.
+ *          and line number where the log occurred. It appends a logger_breadcrumb_t
+ *          to a circular trail in the logger buffer, overwriting the oldest entry
+ *          when the trail is full. The append takes constant time and does not
+ *          call the C library, so it can be used from fault handlers.
  *
  * @param[in] file   A pointer to the source file name.
  * @param[in] line   The line number in the source file.
@@ -205,9 +1322,56 @@ void LOG(int level, const char *file, const char *function, int line, const char
 void LOG(const char *file, int line);
 
 /**
- * @brief This function directs the strings and arguments to be logged.
+ * @brief   Recover the trail of the previous boot.
+ *
+ * @details This function validates the header of the trail and copies its newest entries, oldest first, into the
+ *          provided array. A new trail is started afterwards, so it must be called once at startup before the first
+ *          LOGGER(). The trail only survives a reset when it is placed in a no-init section with
+ *          LOGGER_NOINIT_SECTION, e.g. -DLOGGER_NOINIT_SECTION=\".noinit\" for a NOLOAD section of the linker
+ *          script; otherwise nothing is recovered.
+ *
+ * @param[out] breadcrumbs   The array where the entries will be copied.
+ * @param[in]  size          The number of entries the array can hold.
+ *
+ * @return  The number of entries copied, or 0 if there is no valid trail.
+ */
+uint16_t LoggerRecoverCrashLog(logger_breadcrumb_t *breadcrumbs, uint16_t size);
+
+/**
+ * @brief This function directs the strings and arguments to be logged. Calls below LOGGER_MIN_LEVEL compile to
+ *        nothing.
  */
-#define LOGGER(level, ...)  LOG(__FILE__, __LINE__)
+#define LOGGER(level, ...)                                                                          \
+    do {                                                                                            \
+        if ((level) >= LOGGER_MIN_LEVEL) {                                                          \
+            LOG(LOGGER_FILE, __LINE__);                                                             \
+        }                                                                                           \
+    } while (0)
+
+/**
+ * @brief Module tags have no runtime level in hard fault mode, so this macro works like LOGGER().
+ */
+#define LOGGER_TAG(tag, level, ...)                                                 LOGGER(level, __VA_ARGS__)
+
+/**
+ * @brief There is no time source in hard fault mode, so this macro works like LOGGER().
+ */
+#define LOGGER_RATELIMIT(level, per_second, ...)                                    LOGGER(level, __VA_ARGS__)
+
+/**
+ * @brief The trail keeps the newest call sites, so this macro records every call like LOGGER().
+ */
+#define LOGGER_SAMPLED(level, one_in, ...)                                          LOGGER(level, __VA_ARGS__)
+
+/**
+ * @brief The append of a breadcrumb takes constant time, so this macro works like LOGGER() from interrupts too.
+ */
+#define LOGGER_ISR(level, ...)                                                      LOGGER(level, __VA_ARGS__)
+
+/**
+ * @brief The data is not kept in hard fault mode, so this macro only records the call site like LOGGER().
+ */
+#define LOGGER_HEXDUMP(level, data, len)                                            LOGGER(level, "")
 
 #else
 
@@ -216,7 +1380,63 @@ void LOG(const char *file, int line);
  *        space in the memory.
  */
 #define LOGGER(level, ...)
+#define LOGGER_TAG(tag, level, ...)
+#define LOGGER_RATELIMIT(level, per_second, ...)
+#define LOGGER_SAMPLED(level, one_in, ...)
+#define LOGGER_ISR(level, ...)
+#define LOGGER_HEXDUMP(level, data, len)
 
 #endif
 
+/**
+ * @brief Typed fields of LOGGER_KV().
+ *
+ * @details Each field is a pair of the key, which must be a string literal, and the value, converted to long,
+ *          unsigned long, double or const char *.
+ */
+#define LOGGER_INT(key, value)                                                      (" " key "=%ld", (long)(value))
+#define LOGGER_UINT(key, value)                                                     (" " key "=%lu", (unsigned long)(value))
+#define LOGGER_FLOAT(key, value)                                                    (" " key "=%f", (double)(value))
+#define LOGGER_STR(key, value)                                                      (" " key "=%s", (const char *)(value))
+
+/**
+ * @brief Helpers of LOGGER_KV(), which split the fields into the format string and the arguments of LOGGER().
+ */
+#define LOGGER_KV_FORMAT(field)                                                     LOGGER_KV_FIRST field
+#define LOGGER_KV_FIRST(format, value)                                              format
+#define LOGGER_KV_VALUE(field)                                                      , LOGGER_KV_SECOND field
+#define LOGGER_KV_SECOND(format, value)                                             value
+#define LOGGER_KV_COUNT(...)                                                        LOGGER_KV_COUNT_(__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define LOGGER_KV_COUNT_(_1, _2, _3, _4, _5, _6, _7, _8, count, ...)                count
+#define LOGGER_KV_CONCAT(a, b)                                                      LOGGER_KV_CONCAT_(a, b)
+#define LOGGER_KV_CONCAT_(a, b)                                                     a##b
+#define LOGGER_KV_EACH(macro, ...)                                                  LOGGER_KV_CONCAT(LOGGER_KV_EACH_, LOGGER_KV_COUNT(__VA_ARGS__))(macro, __VA_ARGS__)
+#define LOGGER_KV_EACH_1(macro, field)                                              macro(field)
+#define LOGGER_KV_EACH_2(macro, field, ...)                                         macro(field) LOGGER_KV_EACH_1(macro, __VA_ARGS__)
+#define LOGGER_KV_EACH_3(macro, field, ...)                                         macro(field) LOGGER_KV_EACH_2(macro, __VA_ARGS__)
+#define LOGGER_KV_EACH_4(macro, field, ...)                                         macro(field) LOGGER_KV_EACH_3(macro, __VA_ARGS__)
+#define LOGGER_KV_EACH_5(macro, field, ...)                                         macro(field) LOGGER_KV_EACH_4(macro, __VA_ARGS__)
+#define LOGGER_KV_EACH_6(macro, field, ...)                                         macro(field) LOGGER_KV_EACH_5(macro, __VA_ARGS__)
+#define LOGGER_KV_EACH_7(macro, field, ...)                                         macro(field) LOGGER_KV_EACH_6(macro, __VA_ARGS__)
+#define LOGGER_KV_EACH_8(macro, field, ...)                                         macro(field) LOGGER_KV_EACH_7(macro, __VA_ARGS__)
+
+/**
+ * @brief Macro for structured logging of an event with typed fields.
+ *
+ * @details The format string of the log is built at compile time from the event and the keys, e.g.
+ *
+ *              LOGGER_KV(INFO, "motor", LOGGER_INT("rpm", rpm), LOGGER_FLOAT("temp", temp), LOGGER_STR("state", s));
+ *
+ *          prints "motor rpm=1200 temp=36.500000 state=idle" in text modes. In tokenized mode (LOGGER_TOKENIZED) the
+ *          frame only carries the values: integers as varints, floats as 32-bit floats and strings with their
+ *          length, and tools/logger_decode.py restores the event and the keys from the sources. The log goes
+ *          through LOGGER(), so it is filtered, deferred or recorded like any other log.
+ *
+ * @param level   Log level to be used for the message (e.g., DBG, INFO, WARN, ERR, FATAL).
+ * @param event   The name of the event, a string literal.
+ * @param ...     One to eight fields made with LOGGER_INT(), LOGGER_UINT(), LOGGER_FLOAT() or LOGGER_STR().
+ */
+#define LOGGER_KV(level, event, ...)                                                                \
+    LOGGER(level, event LOGGER_KV_EACH(LOGGER_KV_FORMAT, __VA_ARGS__) LOGGER_KV_EACH(LOGGER_KV_VALUE, __VA_ARGS__))
+
 #endif /* LOGGER_LOGGER_H_ */
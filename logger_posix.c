@@ -0,0 +1,623 @@
+/*
+ * logger_posix.c
+ *
+ *  Hosted backend of the logger for POSIX systems, see logger_posix.h.
+ *
+ *  The producers copy every write of the logger into consecutive slots of a lock-free multi-producer queue, the
+ *  same scheme as the log ring of logger.c. The writer thread is the only consumer: it gathers the committed slots
+ *  into one large buffer, writes it with a single write() or copies it into the mapping of the file, and sleeps on
+ *  a semaphore while the queue is empty. A producer posts the semaphore only when the writer announced that it goes
+ *  to sleep, so a busy logger makes no system call per log.
+ */
+
+#if !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE                                                             200809L
+#endif
+
+#include "logger_posix.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#if (LOGGER_POSIX_QUEUE_LENGTH & (LOGGER_POSIX_QUEUE_LENGTH - 1)) != 0
+#error "LOGGER_POSIX_QUEUE_LENGTH must be a power of two"
+#endif
+
+#if LOGGER_POSIX_QUEUE_LENGTH < 2
+#error "LOGGER_POSIX_QUEUE_LENGTH must be at least 2"
+#endif
+
+#if LOGGER_POSIX_SLOT_SIZE > 65535
+#error "LOGGER_POSIX_SLOT_SIZE must fit into 16 bits"
+#endif
+
+#if LOGGER_POSIX_WRITE_SIZE < LOGGER_POSIX_SLOT_SIZE
+#error "LOGGER_POSIX_WRITE_SIZE must hold at least one slot"
+#endif
+
+#ifndef PATH_MAX
+#define PATH_MAX                                                                    4096
+#endif
+
+/**
+ * @brief A slot of the output queue.
+ *
+ * @details The sequence holds the first position of the current lap of the queue when the slot is free, and that
+ *          position plus one once a producer has committed its bytes. The last slot of a write is marked, so that
+ *          the writer thread never splits a log between two files.
+ */
+typedef struct
+{
+    atomic_uint_least32_t sequence;                                                     /**< Free or committed state */
+    uint16_t length;                                                                    /**< Bytes of the slot */
+    bool last;                                                                          /**< Last slot of a write */
+    uint8_t data[LOGGER_POSIX_SLOT_SIZE];                                               /**< Bytes of the write */
+}logger_posix_slot_t;
+
+/**
+ * @brief Lock-free multi-producer, single-consumer queue of the output.
+ */
+static logger_posix_slot_t logger_posix_queue[LOGGER_POSIX_QUEUE_LENGTH];
+
+/**
+ * @brief Position of the next slot to be reserved by a producer.
+ */
+static atomic_uint_least32_t logger_posix_reserve = 0;
+
+/**
+ * @brief Position of the next slot to be read by the writer thread.
+ */
+static uint_least32_t logger_posix_consume = 0;
+
+/**
+ * @brief Position up to which the slots have been written to the file, see LoggerPosixFlush().
+ */
+static atomic_uint_least32_t logger_posix_written = 0;
+
+/**
+ * @brief Number of writes dropped because the queue was full.
+ */
+static atomic_uint_least32_t logger_posix_dropped = 0;
+
+/**
+ * @brief Whether the writer thread is about to sleep and has to be woken up by the next write.
+ */
+static atomic_bool logger_posix_idle = false;
+
+/**
+ * @brief Whether the backend is started.
+ */
+static atomic_bool logger_posix_running = false;
+
+/**
+ * @brief Number of calls of LoggerPosixWrite() in progress, which the writer thread waits for before it stops.
+ */
+static atomic_uint logger_posix_writers = 0;
+
+/**
+ * @brief Wakes the writer thread up.
+ */
+static sem_t logger_posix_wakeup;
+
+/**
+ * @brief The writer thread.
+ */
+static pthread_t logger_posix_thread;
+
+/**
+ * @brief Copy of the configuration passed to LoggerPosixStart().
+ */
+static logger_posix_config_t logger_posix_config;
+
+/**
+ * @brief Start of the monotonic clock of the timestamps.
+ */
+static struct timespec logger_posix_epoch;
+
+/**
+ * @brief Descriptor of the log file, -1 when it is not open.
+ */
+static int logger_posix_fd = -1;
+
+/**
+ * @brief Mapping of the log file in mmap mode, NULL otherwise.
+ */
+static uint8_t *logger_posix_map = NULL;
+
+/**
+ * @brief Number of bytes in the log file.
+ */
+static size_t logger_posix_file_length = 0;
+
+/**
+ * @brief Monotonic time in seconds when the log file was opened.
+ */
+static time_t logger_posix_opened = 0;
+
+/**
+ * @brief Buffer of the writer thread.
+ */
+static uint8_t logger_posix_buffer[LOGGER_POSIX_WRITE_SIZE];
+
+/**
+ * @brief Number of bytes in the buffer of the writer thread.
+ */
+static size_t logger_posix_buffered = 0;
+
+/**
+ * @brief Number of bytes of the complete writes at the start of the buffer of the writer thread.
+ */
+static size_t logger_posix_complete = 0;
+
+/**
+ * @brief   Read the monotonic clock.
+ *
+ * @return  The time in microseconds since LoggerPosixStart().
+ */
+static uint64_t LoggerPosixMicroseconds(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)(now.tv_sec - logger_posix_epoch.tv_sec) * 1000000u +
+            (uint64_t)((now.tv_nsec - logger_posix_epoch.tv_nsec) / 1000);
+}
+
+/**
+ * @brief   Read the monotonic clock for GetMilliseconds().
+ *
+ * @return  The time in milliseconds since LoggerPosixStart().
+ */
+static float LoggerPosixMilliseconds(void) {
+    return (float) LoggerPosixMicroseconds() / 1000.0f;
+}
+
+/**
+ * @brief   Read the monotonic clock in seconds, for the time-based rotation.
+ *
+ * @return  The monotonic time in seconds.
+ */
+static time_t LoggerPosixSeconds(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec;
+}
+
+/**
+ * @brief   Rename the log file to path.1 and shift the older files up to path.keep, or delete it without keep.
+ */
+static void LoggerPosixShift(void) {
+    const logger_posix_config_t *config = &logger_posix_config;
+    char from[PATH_MAX];
+    char to[PATH_MAX];
+
+    if (config->keep == 0) {
+        unlink(config->path);
+    }
+    for (unsigned index = config->keep; index > 0; index--) {
+        if (index > 1) {
+            snprintf(from, sizeof(from), "%s.%u", config->path, index - 1);
+        } else {
+            snprintf(from, sizeof(from), "%s", config->path);
+        }
+        snprintf(to, sizeof(to), "%s.%u", config->path, index);
+        rename(from, to);
+    }
+}
+
+/**
+ * @brief   Open the log file, appending to its previous content.
+ *
+ * @details In mmap mode the file is extended to max_bytes and mapped. It is rotated first if it is already full,
+ *          e.g. after a crash that left the whole mapping in the file.
+ *
+ * @return  true on success, false if the file cannot be opened or mapped.
+ */
+static bool LoggerPosixOpen(void) {
+    const logger_posix_config_t *config = &logger_posix_config;
+    struct stat status;
+
+    logger_posix_fd = open(config->path, config->mmap ? (O_RDWR | O_CREAT) : (O_WRONLY | O_CREAT | O_APPEND), 0644);
+    if (logger_posix_fd < 0) {
+        return false;
+    }
+    logger_posix_file_length = (fstat(logger_posix_fd, &status) == 0) ? (size_t) status.st_size : 0;
+    logger_posix_opened = LoggerPosixSeconds();
+    if (!config->mmap) {
+        return true;
+    }
+    // Start a new file if the previous one has no room left in the mapping.
+    if (logger_posix_file_length >= config->max_bytes) {
+        close(logger_posix_fd);
+        LoggerPosixShift();
+        logger_posix_fd = open(config->path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (logger_posix_fd < 0) {
+            return false;
+        }
+        logger_posix_file_length = 0;
+    }
+    if (ftruncate(logger_posix_fd, (off_t) config->max_bytes) == 0) {
+        void *map = mmap(NULL, config->max_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, logger_posix_fd, 0);
+        if (map != MAP_FAILED) {
+            logger_posix_map = (uint8_t *) map;
+            return true;
+        }
+    }
+    close(logger_posix_fd);
+    logger_posix_fd = -1;
+    return false;
+}
+
+/**
+ * @brief   Close the log file. In mmap mode the file is cut to its written length.
+ */
+static void LoggerPosixClose(void) {
+    if (logger_posix_map != NULL) {
+        msync(logger_posix_map, logger_posix_config.max_bytes, MS_SYNC);
+        munmap(logger_posix_map, logger_posix_config.max_bytes);
+        logger_posix_map = NULL;
+        // Cut the unused end of the mapping. If this fails, it stays in the file, filled with zeros.
+        int result = ftruncate(logger_posix_fd, (off_t) logger_posix_file_length);
+        (void) result;
+    }
+    if (logger_posix_fd >= 0) {
+        close(logger_posix_fd);
+        logger_posix_fd = -1;
+    }
+}
+
+/**
+ * @brief   Close the log file, shift it and the older files, and start a new file.
+ */
+static void LoggerPosixRotate(void) {
+    LoggerPosixClose();
+    LoggerPosixShift();
+    // The logs are dropped until the next rotation if the new file cannot be opened.
+    LoggerPosixOpen();
+}
+
+/**
+ * @brief   Write the start of the buffer of the writer thread to the log file and keep the rest.
+ *
+ * @param[in] length   The number of bytes to be written.
+ */
+static void LoggerPosixWriteOut(size_t length) {
+    const logger_posix_config_t *config = &logger_posix_config;
+    const uint8_t *p = logger_posix_buffer;
+    size_t left = length;
+
+    if (length == 0) {
+        return;
+    }
+    if (config->max_bytes != 0 && logger_posix_file_length != 0 &&
+            logger_posix_file_length + length > config->max_bytes) {
+        LoggerPosixRotate();
+    }
+    if (logger_posix_map != NULL) {
+        // Cut what does not fit into the mapping, which only happens with writes larger than max_bytes.
+        if (left > config->max_bytes - logger_posix_file_length) {
+            left = config->max_bytes - logger_posix_file_length;
+        }
+        memcpy(logger_posix_map + logger_posix_file_length, p, left);
+        logger_posix_file_length += left;
+    } else {
+        while (left > 0 && logger_posix_fd >= 0) {
+            ssize_t written = write(logger_posix_fd, p, left);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                // Drop the bytes that cannot be written.
+                break;
+            }
+            p += written;
+            left -= (size_t) written;
+            logger_posix_file_length += (size_t) written;
+        }
+    }
+    memmove(logger_posix_buffer, logger_posix_buffer + length, logger_posix_buffered - length);
+    logger_posix_buffered -= length;
+    logger_posix_complete = (logger_posix_complete > length) ? logger_posix_complete - length : 0;
+}
+
+/**
+ * @brief   Gather the committed slots of the queue into the buffer of the writer thread and free them.
+ *
+ * @details The complete writes are written out whenever the next slot does not fit into the buffer.
+ *
+ * @return  The number of slots gathered.
+ */
+static uint32_t LoggerPosixDrain(void) {
+    uint32_t count = 0;
+
+    for (;;) {
+        logger_posix_slot_t *slot = &logger_posix_queue[logger_posix_consume & (LOGGER_POSIX_QUEUE_LENGTH - 1)];
+        uint_least32_t lap = logger_posix_consume & ~(uint_least32_t)(LOGGER_POSIX_QUEUE_LENGTH - 1);
+
+        // Stop at the first slot that has not been committed.
+        if (atomic_load(&slot->sequence) != lap + 1) {
+            break;
+        }
+        if (logger_posix_buffered + slot->length > sizeof(logger_posix_buffer)) {
+            LoggerPosixWriteOut(logger_posix_complete);
+        }
+        if (logger_posix_buffered + slot->length > sizeof(logger_posix_buffer)) {
+            // A single write larger than the buffer is split.
+            LoggerPosixWriteOut(logger_posix_buffered);
+        }
+        memcpy(logger_posix_buffer + logger_posix_buffered, slot->data, slot->length);
+        logger_posix_buffered += slot->length;
+        if (slot->last) {
+            logger_posix_complete = logger_posix_buffered;
+        }
+        // Release the slot to the producers for the next lap.
+        atomic_store_explicit(&slot->sequence, lap + LOGGER_POSIX_QUEUE_LENGTH, memory_order_release);
+        logger_posix_consume++;
+        count++;
+    }
+    return count;
+}
+
+/**
+ * @brief   Check if the next slot of the queue is committed.
+ *
+ * @return  true if the writer thread has something to gather.
+ */
+static bool LoggerPosixPending(void) {
+    const logger_posix_slot_t *slot = &logger_posix_queue[logger_posix_consume & (LOGGER_POSIX_QUEUE_LENGTH - 1)];
+    uint_least32_t lap = logger_posix_consume & ~(uint_least32_t)(LOGGER_POSIX_QUEUE_LENGTH - 1);
+
+    return atomic_load(&slot->sequence) == lap + 1;
+}
+
+/**
+ * @brief   Sleep until a write wakes the writer thread up or LOGGER_POSIX_POLL_MS have passed.
+ */
+static void LoggerPosixSleep(void) {
+    struct timespec deadline;
+
+    // Announce the sleep before the last check, so that a write committed in between posts the semaphore.
+    atomic_store(&logger_posix_idle, true);
+    if (!LoggerPosixPending() && atomic_load(&logger_posix_running)) {
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += (long) LOGGER_POSIX_POLL_MS * 1000000L;
+        deadline.tv_sec += deadline.tv_nsec / 1000000000L;
+        deadline.tv_nsec %= 1000000000L;
+        while (sem_timedwait(&logger_posix_wakeup, &deadline) != 0 && errno == EINTR) {
+        }
+    }
+    atomic_store(&logger_posix_idle, false);
+}
+
+/**
+ * @brief   Main function of the writer thread.
+ *
+ * @param[in] argument   Unused.
+ *
+ * @return  NULL.
+ */
+static void* LoggerPosixThread(void *argument) {
+    const logger_posix_config_t *config = &logger_posix_config;
+
+    (void) argument;
+    for (;;) {
+        // Read the writers after the state, so that the last drain sees every write that was accepted.
+        bool running = atomic_load(&logger_posix_running) || atomic_load(&logger_posix_writers) != 0;
+        uint32_t count = LoggerPosixDrain();
+        LoggerPosixWriteOut(logger_posix_complete);
+        if (logger_posix_buffered == 0) {
+            atomic_store(&logger_posix_written, logger_posix_consume);
+        }
+        if (config->max_seconds != 0 && logger_posix_file_length != 0 &&
+                LoggerPosixSeconds() - logger_posix_opened >= (time_t) config->max_seconds) {
+            LoggerPosixRotate();
+        }
+        if (count == 0) {
+            if (!running) {
+                break;
+            }
+            LoggerPosixSleep();
+        }
+    }
+    // Keep the start of a write whose end never came.
+    LoggerPosixWriteOut(logger_posix_buffered);
+    return NULL;
+}
+
+/**
+ * @brief   Wait a little for the writer thread to free slots of the full queue, see LOGGER_POSIX_WAIT_MS.
+ *
+ * @param[in,out] deadline   The time in microseconds when the wait ends, set by the first call of a write.
+ *
+ * @return  true to try again, false to drop the write.
+ */
+static bool LoggerPosixWait(uint64_t *deadline) {
+    struct timespec pause = {.tv_sec = 0, .tv_nsec = 100000L};
+    uint64_t now = LoggerPosixMicroseconds();
+
+    if (LOGGER_POSIX_WAIT_MS == 0 || !atomic_load(&logger_posix_running)) {
+        return false;
+    }
+    if (*deadline == 0) {
+        *deadline = now + (uint64_t) LOGGER_POSIX_WAIT_MS * 1000u;
+    }
+    else if (now >= *deadline) {
+        return false;
+    }
+    if (atomic_exchange(&logger_posix_idle, false)) {
+        sem_post(&logger_posix_wakeup);
+    }
+    nanosleep(&pause, NULL);
+    return true;
+}
+
+/**
+ * @brief   Queue a write of the logger, registered with LoggerRegisterWriteFunction().
+ *
+ * @details The bytes are copied into consecutive slots reserved at once, so that the writes of different threads
+ *          are not interleaved. If the slots are not free, the write waits for them up to LOGGER_POSIX_WAIT_MS and
+ *          is dropped after that. It is dropped as well once LoggerPosixStop() has begun.
+ *
+ * @param[in] p     A pointer to the bytes.
+ * @param[in] len   The number of bytes.
+ */
+static void LoggerPosixWrite(const uint8_t *p, size_t len) {
+    size_t count = (len + LOGGER_POSIX_SLOT_SIZE - 1) / LOGGER_POSIX_SLOT_SIZE;
+    uint_least32_t position;
+    uint64_t deadline = 0;
+
+    if (len == 0) {
+        return;
+    }
+    // Announce the write before the state is read, so that LoggerPosixStop() either waits for it or it is dropped.
+    atomic_fetch_add(&logger_posix_writers, 1);
+    if (count > LOGGER_POSIX_QUEUE_LENGTH || !atomic_load(&logger_posix_running)) {
+        atomic_fetch_add_explicit(&logger_posix_dropped, 1, memory_order_relaxed);
+        atomic_fetch_sub(&logger_posix_writers, 1);
+        return;
+    }
+    position = atomic_load_explicit(&logger_posix_reserve, memory_order_relaxed);
+    for (;;) {
+        // The writer thread frees the slots in order, so the whole range is free if its last slot is.
+        uint_least32_t last = position + (uint_least32_t) count - 1;
+        logger_posix_slot_t *slot = &logger_posix_queue[last & (LOGGER_POSIX_QUEUE_LENGTH - 1)];
+        uint_least32_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+
+        if ((int32_t)(sequence - (last & ~(uint_least32_t)(LOGGER_POSIX_QUEUE_LENGTH - 1))) < 0) {
+            // The slot still holds bytes of the previous lap, so the queue is full.
+            if (!LoggerPosixWait(&deadline)) {
+                atomic_fetch_add_explicit(&logger_posix_dropped, 1, memory_order_relaxed);
+                atomic_fetch_sub(&logger_posix_writers, 1);
+                return;
+            }
+            position = atomic_load_explicit(&logger_posix_reserve, memory_order_relaxed);
+            continue;
+        }
+        if (atomic_compare_exchange_weak_explicit(&logger_posix_reserve, &position, position + (uint_least32_t) count,
+                memory_order_relaxed, memory_order_relaxed)) {
+            break;
+        }
+    }
+    for (size_t index = 0; index < count; index++) {
+        logger_posix_slot_t *slot = &logger_posix_queue[(position + index) & (LOGGER_POSIX_QUEUE_LENGTH - 1)];
+        size_t length = (len < LOGGER_POSIX_SLOT_SIZE) ? len : LOGGER_POSIX_SLOT_SIZE;
+        memcpy(slot->data, p, length);
+        slot->length = (uint16_t) length;
+        slot->last = (index == count - 1);
+        p += length;
+        len -= length;
+    }
+    for (size_t index = 0; index < count; index++) {
+        logger_posix_slot_t *slot = &logger_posix_queue[(position + index) & (LOGGER_POSIX_QUEUE_LENGTH - 1)];
+        // Publish the slot to the writer thread.
+        atomic_store(&slot->sequence, atomic_load_explicit(&slot->sequence, memory_order_relaxed) + 1);
+    }
+    if (atomic_exchange(&logger_posix_idle, false)) {
+        sem_post(&logger_posix_wakeup);
+    }
+    atomic_fetch_sub(&logger_posix_writers, 1);
+}
+
+/**
+ * @brief   Queue a log of the LoggerPrintf function, registered with LoggerRegisterAppFunctions().
+ *
+ * @param[in] p     A pointer to the bytes.
+ * @param[in] len   The number of bytes.
+ */
+static void LoggerPosixPrintf(const uint8_t *p, uint8_t len) {
+    LoggerPosixWrite(p, len);
+}
+
+/**
+ * @brief   Open the log file and start the writer thread.
+ *
+ * @param[in] config   The configuration, copied by the function.
+ *
+ * @return  true on success, false otherwise.
+ */
+bool LoggerPosixStart(const logger_posix_config_t *config) {
+    if (atomic_load(&logger_posix_running) || config == NULL || config->path == NULL ||
+            (config->mmap && config->max_bytes == 0)) {
+        return false;
+    }
+    logger_posix_config = *config;
+    clock_gettime(CLOCK_MONOTONIC, &logger_posix_epoch);
+    if (!LoggerPosixOpen()) {
+        return false;
+    }
+    for (size_t index = 0; index < LOGGER_POSIX_QUEUE_LENGTH; index++) {
+        atomic_init(&logger_posix_queue[index].sequence, 0);
+    }
+    atomic_store(&logger_posix_reserve, 0);
+    atomic_store(&logger_posix_written, 0);
+    atomic_store(&logger_posix_dropped, 0);
+    atomic_store(&logger_posix_idle, false);
+    logger_posix_consume = 0;
+    logger_posix_buffered = 0;
+    logger_posix_complete = 0;
+    if (sem_init(&logger_posix_wakeup, 0, 0) != 0) {
+        LoggerPosixClose();
+        return false;
+    }
+    atomic_store(&logger_posix_running, true);
+    if (pthread_create(&logger_posix_thread, NULL, LoggerPosixThread, NULL) != 0) {
+        atomic_store(&logger_posix_running, false);
+        sem_destroy(&logger_posix_wakeup);
+        LoggerPosixClose();
+        return false;
+    }
+    LoggerRegisterTicksFunction(LoggerPosixMicroseconds, 1000000);
+    LoggerRegisterAppFunctions(LoggerPosixMilliseconds, LoggerPosixPrintf);
+    LoggerRegisterWriteFunction(LoggerPosixWrite);
+    return true;
+}
+
+/**
+ * @brief   Wait until the writer thread has written everything that was queued before the call.
+ */
+void LoggerPosixFlush(void) {
+    uint_least32_t target = atomic_load(&logger_posix_reserve);
+
+    while (atomic_load(&logger_posix_running) && (int32_t)(atomic_load(&logger_posix_written) - target) < 0) {
+        struct timespec pause = {.tv_sec = 0, .tv_nsec = 1000000L};
+        if (atomic_exchange(&logger_posix_idle, false)) {
+            sem_post(&logger_posix_wakeup);
+        }
+        nanosleep(&pause, NULL);
+    }
+}
+
+/**
+ * @brief   Write out the queue, stop the writer thread and close the log file.
+ */
+void LoggerPosixStop(void) {
+    if (!atomic_load(&logger_posix_running)) {
+        return;
+    }
+    LoggerRegisterWriteFunction(NULL);
+    LoggerRegisterAppFunctions(NULL, NULL);
+    LoggerRegisterTicksFunction(NULL, 0);
+    // The writes still running are written out by the writer thread before it stops, the later ones are dropped.
+    atomic_store(&logger_posix_running, false);
+    sem_post(&logger_posix_wakeup);
+    pthread_join(logger_posix_thread, NULL);
+    sem_destroy(&logger_posix_wakeup);
+    LoggerPosixClose();
+}
+
+/**
+ * @brief   Get the number of writes dropped because the queue was full.
+ *
+ * @return  The number of dropped writes.
+ */
+uint32_t LoggerPosixDropped(void) {
+    return atomic_load(&logger_posix_dropped);
+}
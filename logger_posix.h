@@ -0,0 +1,114 @@
+/*
+ * logger_posix.h
+ *
+ *  Hosted backend of the logger for POSIX systems, e.g. a Linux gateway.
+ *
+ *  A writer thread drains a lock-free queue of the log output into large buffered writes to a file, which is rotated
+ *  by size and by age, so the threads that log do not wait for the disk, see LOGGER_POSIX_WAIT_MS. It is built next
+ *  to logger.c:
+ *
+ *      cc -O2 -I. -DLOGGER_ENABLED -DLOGGER_THREAD_SAFE -DLOGGER_THREAD_LOCAL logger.c logger_posix.c app.c -lpthread
+ */
+
+#ifndef LOGGER_LOGGER_POSIX_H_
+#define LOGGER_LOGGER_POSIX_H_
+
+#include "logger.h"
+
+/**
+ * @brief Number of slots of the output queue, a power of two of at least 2.
+ *
+ * @details Every slot holds up to LOGGER_POSIX_SLOT_SIZE bytes, a longer write takes several consecutive slots.
+ *          A write that does not fit into the free slots waits up to LOGGER_POSIX_WAIT_MS for the writer thread,
+ *          then it is dropped whole and counted, see LoggerPosixDropped(). A write is never cut.
+ */
+#ifndef LOGGER_POSIX_QUEUE_LENGTH
+#define LOGGER_POSIX_QUEUE_LENGTH                                                   4096
+#endif
+
+/**
+ * @brief Number of bytes of a slot of the output queue.
+ *
+ * @details The slots are small, so that a short log does not hold the room of a long one.
+ */
+#ifndef LOGGER_POSIX_SLOT_SIZE
+#define LOGGER_POSIX_SLOT_SIZE                                                      64
+#endif
+
+/**
+ * @brief Longest time in milliseconds a write waits for free slots when the queue is full, 0 to drop it at once.
+ *
+ * @details The wait slows the threads that log down to the speed of the disk instead of losing their logs. It is
+ *          bounded, so that a stuck disk cannot stop the application.
+ */
+#ifndef LOGGER_POSIX_WAIT_MS
+#define LOGGER_POSIX_WAIT_MS                                                        0
+#endif
+
+/**
+ * @brief Size of the buffer that the writer thread fills before every write().
+ */
+#ifndef LOGGER_POSIX_WRITE_SIZE
+#define LOGGER_POSIX_WRITE_SIZE                                                     65536
+#endif
+
+/**
+ * @brief Longest time in milliseconds the writer thread sleeps, which bounds the delay of the time-based rotation.
+ */
+#ifndef LOGGER_POSIX_POLL_MS
+#define LOGGER_POSIX_POLL_MS                                                        100
+#endif
+
+/**
+ * @brief Configuration of the hosted backend.
+ */
+typedef struct
+{
+    const char *path;                                                                   /**< Path of the log file */
+    size_t max_bytes;                                                                   /**< Size that rotates the file, 0 for no limit */
+    uint32_t max_seconds;                                                               /**< Age that rotates the file, 0 for no limit */
+    uint8_t keep;                                                                       /**< Rotated files kept as path.1 to path.keep */
+    bool mmap;                                                                          /**< Write through a mapping of max_bytes of the file */
+}logger_posix_config_t;
+
+/**
+ * @brief   Open the log file and start the writer thread.
+ *
+ * @details The backend registers itself with LoggerRegisterAppFunctions() and LoggerRegisterWriteFunction(), so
+ *          every log of the logger goes through its queue, with timestamps of the monotonic clock. When the file
+ *          grows past max_bytes or gets older than max_seconds, it is closed and renamed to path.1, the older
+ *          files are shifted up to path.keep, and a new file is started. With mmap, the file is mapped with its
+ *          full size of max_bytes, the logs are copied into the mapping and the file is cut to its written length
+ *          when it is closed.
+ *
+ * @param[in] config   The configuration, copied by the function. The path must stay valid until
+ *                     LoggerPosixStop().
+ *
+ * @return  true on success, false if the backend is already started, the file cannot be opened or mmap is set
+ *          without max_bytes.
+ */
+bool LoggerPosixStart(const logger_posix_config_t *config);
+
+/**
+ * @brief   Wait until the writer thread has written everything that was queued before the call.
+ */
+void LoggerPosixFlush(void);
+
+/**
+ * @brief   Write out the queue, stop the writer thread and close the log file.
+ *
+ * @details The output functions of the logger are unregistered first, so the logs after this call are not printed.
+ *          The writes that are already running in other threads are written out before the writer thread stops,
+ *          the writes that start later are counted as dropped.
+ */
+void LoggerPosixStop(void);
+
+/**
+ * @brief   Get the number of writes dropped because the queue was full or the backend was stopping, since
+ *          LoggerPosixStart().
+ *
+ * @return  The number of dropped writes.
+ */
+uint32_t LoggerPosixDropped(void);
+
+#endif /* LOGGER_LOGGER_POSIX_H_ */
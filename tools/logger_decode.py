@@ -0,0 +1,364 @@
+#!/usr/bin/env python3
+"""
+logger_decode.py
+
+Host-side decoder of the tokenized logger output (LOGGER_TOKENIZED).
+
+The device sends one frame per log instead of text:
+
+    0xA5 | length | token (u32 LE) | timestamp ms (u32 LE) | level (u8) | packed arguments
+
+The token is the FNV-1a hash of the file name and the line of the LOGGER(),
+LOGGER_TAG(), LOGGER_RATELIMIT(), LOGGER_SAMPLED(), LOGGER_ISR(), LOGGER_KV()
+or LOGGER_HEXDUMP() call, so the string table can be generated from the sources:
+
+    logger_decode.py table -o tokens.json src/
+    logger_decode.py decode tokens.json capture.bin
+
+"-" reads the capture from stdin, e.g. when piping a serial port.
+
+The trail of the hard fault logger (HARD_FAULT_LOGGER_ENABLED), as copied by
+GetLoggerBuffer(), is a sequence of {file id (u16 LE), line (u16 LE)} entries
+where the file id is the FNV-1a hash of the file name folded to 16 bits:
+
+    logger_decode.py breadcrumbs trail.bin src/
+"""
+
+import argparse
+import json
+import os
+import re
+import struct
+import sys
+
+SYNC = 0xA5
+HEADER_LENGTH = 9
+TOKEN_DROPPED = 0
+LEVELS = ["DBG", "INFO", "WARN", "ERR", "FATAL"]
+SOURCE_EXTENSIONS = (".c", ".h", ".cc", ".cpp", ".hpp")
+
+# Positions of the level and of the format string in the arguments of the logging macros.
+MACROS = {"LOGGER": (0, 1), "LOGGER_TAG": (1, 2), "LOGGER_RATELIMIT": (0, 2), "LOGGER_SAMPLED": (0, 2),
+          "LOGGER_ISR": (0, 1)}
+# LOGGER_RATELIMIT() sends its summary with the token of the negated line.
+SUPPRESSED_FMT = "%lu logs suppressed"
+# Bytes per row of the LOGGER_HEXDUMP() frames, as printed by the device in text modes.
+HEXDUMP_ROW_BYTES = 16
+# Conversions of the typed fields of LOGGER_KV(), which builds its format string from " key=<conversion>".
+KV_FIELDS = {"LOGGER_INT": "%ld", "LOGGER_UINT": "%lu", "LOGGER_FLOAT": "%f", "LOGGER_STR": "%s"}
+KV_FIELD = re.compile(r'(%s)\s*\(\s*"((?:[^"\\]|\\.)*)"\s*,' % "|".join(KV_FIELDS), re.S)
+
+FNV_OFFSET = 0x811C9DC5
+FNV_PRIME = 0x01000193
+
+# Same grammar as LoggerParseSpec() in logger.c.
+SPEC = re.compile(r"%([-+ #0]*)([0-9*.]*)(hh|h|ll|l|j|z|t|L)?(.?)", re.S)
+ESCAPES = {"n": "\n", "t": "\t", "r": "\r", "0": "\0", "\\": "\\", "'": "'",
+           '"': '"', "a": "\a", "b": "\b", "f": "\f", "v": "\v", "?": "?"}
+
+
+def tokenize(file_name, line):
+    """Calculate the token of a call site like LoggerTokenize()."""
+    value = FNV_OFFSET
+    for byte in os.path.basename(file_name).encode() + struct.pack("<I", line & 0xFFFFFFFF):
+        value = ((value ^ byte) * FNV_PRIME) & 0xFFFFFFFF
+    return value if value != TOKEN_DROPPED else 1
+
+
+def file_id(file_name):
+    """Calculate the file id of a breadcrumb like LoggerFileId()."""
+    value = FNV_OFFSET
+    for byte in os.path.basename(file_name).encode():
+        value = ((value ^ byte) * FNV_PRIME) & 0xFFFFFFFF
+    return (value ^ (value >> 16)) & 0xFFFF
+
+
+def unescape(literal):
+    """Decode the escape sequences of a C string literal."""
+    return re.sub(r"\\(x[0-9a-fA-F]+|[0-7]{1,3}|.)",
+                  lambda m: (chr(int(m.group(1)[1:], 16)) if m.group(1)[0] == "x"
+                             else chr(int(m.group(1), 8)) if m.group(1)[0].isdigit()
+                             else ESCAPES.get(m.group(1), m.group(1))),
+                  literal)
+
+
+def split_arguments(text, start):
+    """Split the arguments of a call that opens at text[start], return them and the end offset."""
+    depth, index, current, arguments = 0, start, "", []
+    while index < len(text):
+        char = text[index]
+        if char in "\"'":
+            end = index + 1
+            while end < len(text) and text[end] != char:
+                end += 2 if text[end] == "\\" else 1
+            current += text[index:end + 1]
+            index = end + 1
+            continue
+        if char == "(":
+            depth += 1
+            if depth == 1:
+                index += 1
+                continue
+        elif char == ")":
+            depth -= 1
+            if depth == 0:
+                arguments.append(current.strip())
+                return arguments, index
+        elif char == "," and depth == 1:
+            arguments.append(current.strip())
+            current = ""
+            index += 1
+            continue
+        current += char
+        index += 1
+    return None, index
+
+
+def scan_file(path, table):
+    """Add the logging macro calls of a source file to the table."""
+    with open(path, encoding="utf-8", errors="replace") as source:
+        text = source.read()
+    for match in re.finditer(r"\b(%s)\s*\(" % "|".join(MACROS), text):
+        level_position, position = MACROS[match.group(1)]
+        arguments, _ = split_arguments(text, match.end() - 1)
+        if not arguments or len(arguments) <= position:
+            continue
+        literals = re.fullmatch(r'(\s*"(?:[^"\\]|\\.)*"\s*)+', arguments[position], re.S)
+        if literals is None:
+            continue
+        fmt = "".join(unescape(part) for part in re.findall(r'"((?:[^"\\]|\\.)*)"', arguments[position], re.S))
+        line = text.count("\n", 0, match.start()) + 1
+        level = arguments[level_position]
+        table["%08x" % tokenize(path, line)] = {"file": os.path.basename(path), "line": line, "level": level,
+                                               "fmt": fmt}
+        if match.group(1) == "LOGGER_RATELIMIT":
+            table["%08x" % tokenize(path, -line)] = {"file": os.path.basename(path), "line": line,
+                                                    "level": level, "fmt": SUPPRESSED_FMT}
+    for match in re.finditer(r"\bLOGGER_HEXDUMP\s*\(", text):
+        arguments, _ = split_arguments(text, match.end() - 1)
+        if not arguments or len(arguments) != 3:
+            continue
+        line = text.count("\n", 0, match.start()) + 1
+        table["%08x" % tokenize(path, line)] = {"file": os.path.basename(path), "line": line,
+                                               "level": arguments[0], "fmt": "", "hexdump": True}
+    for match in re.finditer(r"\bLOGGER_KV\s*\(", text):
+        arguments, _ = split_arguments(text, match.end() - 1)
+        if not arguments or len(arguments) < 3:
+            continue
+        event = re.fullmatch(r'"((?:[^"\\]|\\.)*)"', arguments[1], re.S)
+        fields = [KV_FIELD.match(argument) for argument in arguments[2:]]
+        if event is None or None in fields:
+            continue
+        fmt = unescape(event.group(1)) + "".join(" %s=%s" % (unescape(field.group(2)), KV_FIELDS[field.group(1)])
+                                                 for field in fields)
+        line = text.count("\n", 0, match.start()) + 1
+        table["%08x" % tokenize(path, line)] = {"file": os.path.basename(path), "line": line,
+                                               "level": arguments[0], "fmt": fmt}
+
+
+def source_files(paths):
+    """List the source files of files and directories."""
+    for path in paths:
+        if os.path.isdir(path):
+            for root, _, files in os.walk(path):
+                for name in sorted(files):
+                    if name.endswith(SOURCE_EXTENSIONS):
+                        yield os.path.join(root, name)
+        else:
+            yield path
+
+
+def build_table(paths):
+    """Scan files and directories for LOGGER() calls."""
+    table = {}
+    for path in source_files(paths):
+        scan_file(path, table)
+    return table
+
+
+def decode_breadcrumbs(paths, stream, output):
+    """Print the hard fault logger trail, oldest entry first."""
+    names = {}
+    for path in source_files(paths):
+        names.setdefault(file_id(path), set()).add(os.path.basename(path))
+    data = stream.read()
+    for offset in range(0, len(data) - 3, 4):
+        identifier, line = struct.unpack_from("<HH", data, offset)
+        if line == 0:
+            continue
+        name = "|".join(sorted(names.get(identifier, {"unknown file %04x" % identifier})))
+        output.write("%s : %d\n" % (name, line))
+
+
+class Reader:
+    """Reads the packed arguments of a frame."""
+
+    def __init__(self, data):
+        self.data = data
+        self.offset = 0
+
+    def varint(self):
+        value, shift = 0, 0
+        while True:
+            if self.offset >= len(self.data):
+                raise EOFError
+            byte = self.data[self.offset]
+            self.offset += 1
+            value |= (byte & 0x7F) << shift
+            shift += 7
+            if not byte & 0x80:
+                return value
+
+    def zigzag(self):
+        value = self.varint()
+        return (value >> 1) ^ -(value & 1)
+
+    def real(self):
+        if self.offset + 4 > len(self.data):
+            raise EOFError
+        value = struct.unpack_from("<f", self.data, self.offset)[0]
+        self.offset += 4
+        return value
+
+    def string(self):
+        length = self.varint()
+        if self.offset + length > len(self.data):
+            raise EOFError
+        value = self.data[self.offset:self.offset + length].decode("utf-8", "replace")
+        self.offset += length
+        return value
+
+
+def render(fmt, data):
+    """Rebuild the message of a frame from its format string and packed arguments."""
+    reader = Reader(data)
+    output, position = [], 0
+    for match in SPEC.finditer(fmt):
+        output.append(fmt[position:match.start()])
+        position = match.end()
+        flags, width, _, conversion = match.groups()
+        if conversion == "%":
+            output.append("%")
+            continue
+        try:
+            # Width and precision passed as '*' come first. As in C, a negative width is a '-' flag and a negative
+            # precision is ignored.
+            field, dot, precision = width.partition(".")
+            if field == "*":
+                value = reader.zigzag()
+                field = str(abs(value))
+                flags += "-" if value < 0 else ""
+            if precision == "*":
+                value = reader.zigzag()
+                dot, precision = (".", str(value)) if value >= 0 else ("", "")
+            width = field + dot + precision
+            if conversion in "di":
+                output.append(("%" + flags + width + "d") % reader.zigzag())
+            elif conversion in "uoxXc":
+                value = reader.varint()
+                output.append(("%" + flags + width + ("d" if conversion == "u" else conversion)) % value)
+            elif conversion == "p":
+                output.append("0x%x" % reader.varint())
+            elif conversion in "eEfFgGaA":
+                if conversion in "aA":
+                    output.append(float.hex(reader.real()))
+                else:
+                    output.append(("%" + flags + width + conversion) % reader.real())
+            elif conversion == "s":
+                output.append(("%" + flags + width + "s") % reader.string())
+            else:
+                output.append(match.group(0))
+        except EOFError:
+            # The argument did not fit into the frame.
+            output.append(match.group(0))
+    output.append(fmt[position:])
+    return "".join(output)
+
+
+def render_hexdump(data):
+    """Rebuild the rows of a LOGGER_HEXDUMP() frame: the offset of its first byte, then its bytes."""
+    reader = Reader(data)
+    try:
+        offset = reader.varint()
+        length = reader.varint()
+    except EOFError:
+        return [data.hex()]
+    chunk = reader.data[reader.offset:reader.offset + length]
+    rows = []
+    for start in range(0, len(chunk), HEXDUMP_ROW_BYTES):
+        row = chunk[start:start + HEXDUMP_ROW_BYTES]
+        rows.append("%08x: %-*s |%s|" % (offset + start, 3 * HEXDUMP_ROW_BYTES - 1, " ".join("%02x" % b for b in row),
+                                         "".join(chr(b) if 0x20 <= b < 0x7F else "." for b in row)))
+    return rows
+
+
+def decode(table, stream, output):
+    """Decode every frame of a capture, skipping bytes that do not belong to a frame."""
+    data = stream.read()
+    offset = 0
+    while offset + 2 <= len(data):
+        if data[offset] != SYNC:
+            offset += 1
+            continue
+        length = data[offset + 1]
+        frame = data[offset + 2:offset + 2 + length]
+        if length < HEADER_LENGTH or len(frame) < length:
+            offset += 1
+            continue
+        token, timestamp, level = struct.unpack_from("<IIB", frame)
+        arguments = frame[HEADER_LENGTH:]
+        level_name = LEVELS[level] if level < len(LEVELS) else str(level)
+        if token == TOKEN_DROPPED:
+            output.write("[%u] : %s : %s logs dropped\n" % (timestamp, level_name, render("%u", arguments)))
+        elif table.get("%08x" % token, {}).get("hexdump"):
+            entry = table["%08x" % token]
+            for row in render_hexdump(arguments):
+                output.write("[%u] : %s : %s : %d -> %s\n" % (timestamp, level_name, entry["file"], entry["line"], row))
+        elif "%08x" % token in table:
+            entry = table["%08x" % token]
+            output.write("[%u] : %s : %s : %d -> %s\n" % (timestamp, level_name, entry["file"], entry["line"],
+                                                         render(entry["fmt"], arguments)))
+        else:
+            output.write("[%u] : %s : unknown token %08x : %s\n" % (timestamp, level_name, token, arguments.hex()))
+        offset += 2 + length
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode the tokenized logger output.")
+    commands = parser.add_subparsers(dest="command", required=True)
+    table_command = commands.add_parser("table", help="generate the string table from the sources")
+    table_command.add_argument("sources", nargs="+", help="source files or directories")
+    table_command.add_argument("-o", "--output", default="-", help="output JSON file")
+    decode_command = commands.add_parser("decode", help="decode a capture")
+    decode_command.add_argument("table", help="string table generated by the table command")
+    decode_command.add_argument("capture", nargs="?", default="-", help="binary capture")
+    breadcrumbs_command = commands.add_parser("breadcrumbs", help="decode a hard fault logger trail")
+    breadcrumbs_command.add_argument("trail", help="trail copied by GetLoggerBuffer(), \"-\" for stdin")
+    breadcrumbs_command.add_argument("sources", nargs="+", help="source files or directories")
+    arguments = parser.parse_args()
+
+    if arguments.command == "table":
+        table = build_table(arguments.sources)
+        if arguments.output == "-":
+            json.dump(table, sys.stdout, indent=2, sort_keys=True)
+        else:
+            with open(arguments.output, "w", encoding="utf-8") as output:
+                json.dump(table, output, indent=2, sort_keys=True)
+    elif arguments.command == "breadcrumbs":
+        if arguments.trail == "-":
+            decode_breadcrumbs(arguments.sources, sys.stdin.buffer, sys.stdout)
+        else:
+            with open(arguments.trail, "rb") as trail:
+                decode_breadcrumbs(arguments.sources, trail, sys.stdout)
+    else:
+        with open(arguments.table, encoding="utf-8") as table_file:
+            table = json.load(table_file)
+        if arguments.capture == "-":
+            decode(table, sys.stdin.buffer, sys.stdout)
+        else:
+            with open(arguments.capture, "rb") as capture:
+                decode(table, capture, sys.stdout)
+
+
+if __name__ == "__main__":
+    main()